@@ -0,0 +1,93 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+//microbenchmark of DynamicSet against std::vector, run with an optional element count (default 1000000)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "utility/DynamicSet.hpp"
+
+struct Particle
+{
+    float Position[3];
+    float Velocity[3];
+    int Id;
+};
+
+//keeps results alive so the optimizer can't drop the loops being timed
+static volatile long long Sink = 0;
+
+template<typename Function>
+static double TimeMilliseconds(Function&& Run, int Repeats = 5)
+{
+    double Best = 1e30;
+    for (int r = 0; r < Repeats; r++)
+    {
+        const auto Start = std::chrono::steady_clock::now();
+        Run();
+        const auto End = std::chrono::steady_clock::now();
+        const double Elapsed = std::chrono::duration<double, std::milli>(End - Start).count();
+        Best = Elapsed < Best ? Elapsed : Best;
+    }
+    return Best;
+}
+
+static void Report(const char* Name, const double SetMs, const double VectorMs)
+{
+    printf("%-32s DynamicSet %9.3f ms   std::vector %9.3f ms   ratio %.2f\n", Name, SetMs, VectorMs, SetMs / VectorMs);
+}
+
+template<typename SetType>
+static void AddParticles(SetType& Set, const int Count)
+{
+    for (int i = 0; i < Count; i++)
+    {
+        Set.Add({{0, 0, 0}, {1, 1, 1}, i});
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int Count = argc > 1 ? atoi(argv[1]) : 1000000;
+    printf("%d elements, best of 5\n", Count);
+
+    Report("add, trivially copyable",
+        TimeMilliseconds([&] { DynamicSet<Particle> Set; AddParticles(Set, Count); Sink += Set.Num(); }),
+        TimeMilliseconds([&] { std::vector<Particle> Vector; for (int i = 0; i < Count; i++) Vector.push_back({{0, 0, 0}, {1, 1, 1}, i}); Sink += Vector.size(); }));
+
+    Report("add, stable addresses",
+        TimeMilliseconds([&] { DynamicSet<Particle, 0, true> Set; AddParticles(Set, Count); Sink += Set.Num(); }),
+        TimeMilliseconds([&] { std::vector<Particle> Vector; for (int i = 0; i < Count; i++) Vector.push_back({{0, 0, 0}, {1, 1, 1}, i}); Sink += Vector.size(); }));
+
+    Report("add, move only",
+        TimeMilliseconds([&] { DynamicSet<std::unique_ptr<int>> Set; for (int i = 0; i < Count; i++) Set.Add(std::make_unique<int>(i)); Sink += Set.Num(); }),
+        TimeMilliseconds([&] { std::vector<std::unique_ptr<int>> Vector; for (int i = 0; i < Count; i++) Vector.push_back(std::make_unique<int>(i)); Sink += Vector.size(); }));
+
+    //many short lived small sets, where inline storage avoids the heap entirely
+    Report("many sets of 8, inline storage",
+        TimeMilliseconds([&] { for (int s = 0; s < Count / 8; s++) { DynamicSet<int, 8> Set; for (int i = 0; i < 8; i++) Set.Add(i); Sink += Set[7]; } }),
+        TimeMilliseconds([&] { for (int s = 0; s < Count / 8; s++) { std::vector<int> Vector; for (int i = 0; i < 8; i++) Vector.push_back(i); Sink += Vector[7]; } }));
+
+    //swap-with-last removal of every element from the front
+    Report("remove from front",
+        TimeMilliseconds([&] { DynamicSet<Particle> Set; AddParticles(Set, Count); while (Set.RemoveIndex(0)) {} Sink += Set.Num(); }),
+        TimeMilliseconds([&] {
+            std::vector<Particle> Vector;
+            for (int i = 0; i < Count; i++) Vector.push_back({{0, 0, 0}, {1, 1, 1}, i});
+            while (!Vector.empty()) { Vector[0] = Vector.back(); Vector.pop_back(); }
+            Sink += Vector.size();
+        }));
+
+    //refilling a set that has been emptied reuses its storage
+    DynamicSet<Particle> Reused;
+    std::vector<Particle> ReusedVector;
+    Report("refill after empty",
+        TimeMilliseconds([&] { Reused.Empty(); AddParticles(Reused, Count); Sink += Reused.Num(); }),
+        TimeMilliseconds([&] { ReusedVector.clear(); for (int i = 0; i < Count; i++) ReusedVector.push_back({{0, 0, 0}, {1, 1, 1}, i}); Sink += ReusedVector.size(); }));
+
+    return 0;
+}
@@ -0,0 +1,293 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+//throughput of rewriting and the turtle over every system in a directory, default resource/systems/example, run
+//at every iteration count from 1 up to the system's own plus an optional extra. Results are written as JSON in the
+//layout Google Benchmark uses, so they can be compared across runs to catch regressions
+//usage: SystemBenchmark [-d DIRECTORY] [-o OUTPUT.json] [-e EXTRA_ITERATIONS] [-r REPETITIONS]
+//a line per case is printed to stderr, stdout carries the engine's own logging
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <vector>
+#include "lindenmayer/lindenmayer.h"
+#include "utility/Turtle.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+//heap allocations through operator new, which covers the containers. Arena blocks and the turtle's triangle list
+//come from malloc, and show up in the peak resident set instead
+static std::atomic<uint64_t> NumAllocations{0};
+static std::atomic<uint64_t> AllocatedBytes{0};
+
+void* operator new(const size_t Size)
+{
+    NumAllocations.fetch_add(1, std::memory_order_relaxed);
+    AllocatedBytes.fetch_add(Size, std::memory_order_relaxed);
+    void* Memory = malloc(Size == 0 ? 1 : Size);
+    if (Memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return Memory;
+}
+
+void* operator new[](const size_t Size)
+{
+    return operator new(Size);
+}
+
+void operator delete(void* Memory) noexcept
+{
+    free(Memory);
+}
+
+void operator delete[](void* Memory) noexcept
+{
+    free(Memory);
+}
+
+void operator delete(void* Memory, size_t) noexcept
+{
+    free(Memory);
+}
+
+void operator delete[](void* Memory, size_t) noexcept
+{
+    free(Memory);
+}
+
+//resets the peak resident set to the current one where the system allows it, so each case reports its own peak
+static void ResetPeakResidentSet()
+{
+#if defined(__linux__)
+    FILE* fp = fopen("/proc/self/clear_refs", "w");
+    if (fp != nullptr)
+    {
+        fputs("5", fp);
+        fclose(fp);
+    }
+#endif
+}
+
+//peak resident set in bytes, since the last reset on linux and since the process started elsewhere
+static uint64_t GetPeakResidentSet()
+{
+#if defined(__linux__)
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (fp != nullptr)
+    {
+        char Line[256];
+        unsigned long long Kilobytes = 0;
+        while (fgets(Line, sizeof(Line), fp) != nullptr)
+        {
+            if (sscanf(Line, "VmHWM: %llu kB", &Kilobytes) == 1)
+            {
+                break;
+            }
+        }
+        fclose(fp);
+        return Kilobytes * 1024;
+    }
+#endif
+#if defined(__linux__) || defined(__APPLE__)
+    rusage Usage{};
+    getrusage(RUSAGE_SELF, &Usage);
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(Usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(Usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+struct CaseResult
+{
+    std::string Name;
+    int Repetitions = 0;
+    double RewriteSeconds = 0.0;
+    double TurtleSeconds = 0.0;
+    size_t NumSymbols = 0;
+    size_t NumSegments = 0;
+    long long NumTriangles = 0;
+    uint64_t PeakResidentSet = 0;
+    uint64_t NumAllocations = 0;
+    uint64_t AllocatedBytes = 0;
+};
+
+//rewrites and draws System Repetitions times, keeping the fastest rewrite and drawing. Allocations are counted over
+//the first repetition, which is the only one that grows the buffers
+static CaseResult RunCase(LSystem& System, Turtle& DrawingTurtle, ColoredTriangleList** Triangles, const int Repetitions)
+{
+    CaseResult Result;
+    Result.Repetitions = Repetitions;
+    Result.RewriteSeconds = 1e30;
+    Result.TurtleSeconds = 1e30;
+
+    ResetPeakResidentSet();
+    for (int Repetition = 0; Repetition < Repetitions; Repetition++)
+    {
+        const uint64_t AllocationsBefore = NumAllocations.load();
+        const uint64_t BytesBefore = AllocatedBytes.load();
+
+        const auto RewriteStart = std::chrono::steady_clock::now();
+        System.Reset();
+        System.Rewrite();
+        const auto TurtleStart = std::chrono::steady_clock::now();
+        DrawingTurtle.Reset();
+        DrawingTurtle.DrawSystem(System, Triangles);
+        const auto TurtleEnd = std::chrono::steady_clock::now();
+
+        if (Repetition == 0)
+        {
+            Result.NumAllocations = NumAllocations.load() - AllocationsBefore;
+            Result.AllocatedBytes = AllocatedBytes.load() - BytesBefore;
+        }
+
+        Result.RewriteSeconds = std::min(Result.RewriteSeconds, std::chrono::duration<double>(TurtleStart - RewriteStart).count());
+        Result.TurtleSeconds = std::min(Result.TurtleSeconds, std::chrono::duration<double>(TurtleEnd - TurtleStart).count());
+    }
+
+    const char* Output = System.GetOutputString();
+    Result.NumSymbols = Output != nullptr ? strlen(Output) : 0;
+    Result.NumSegments = DrawingTurtle.Segments.size();
+    Result.NumTriangles = *Triangles != nullptr ? (*Triangles)->NumTriangles : 0;
+    Result.PeakResidentSet = GetPeakResidentSet();
+    return Result;
+}
+
+//items per second, 0 for cases too quick to time
+static double Rate(const double Items, const double Seconds)
+{
+    return Seconds > 0.0 ? Items / Seconds : 0.0;
+}
+
+static void WriteJson(FILE* fp, const std::vector<CaseResult>& Results)
+{
+    char Date[64];
+    const time_t Now = time(nullptr);
+    strftime(Date, sizeof(Date), "%Y-%m-%dT%H:%M:%S", localtime(&Now));
+
+    fprintf(fp, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"executable\": \"SystemBenchmark\"\n  },\n", Date);
+    fprintf(fp, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < Results.size(); i++)
+    {
+        const CaseResult& Result = Results[i];
+        const double TotalSeconds = Result.RewriteSeconds + Result.TurtleSeconds;
+        fprintf(fp, "    {\n");
+        fprintf(fp, "      \"name\": \"%s\",\n", Result.Name.c_str());
+        fprintf(fp, "      \"run_type\": \"iteration\",\n");
+        fprintf(fp, "      \"iterations\": %d,\n", Result.Repetitions);
+        fprintf(fp, "      \"real_time\": %.6f,\n", TotalSeconds * 1e3);
+        fprintf(fp, "      \"time_unit\": \"ms\",\n");
+        fprintf(fp, "      \"rewrite_time\": %.6f,\n", Result.RewriteSeconds * 1e3);
+        fprintf(fp, "      \"turtle_time\": %.6f,\n", Result.TurtleSeconds * 1e3);
+        fprintf(fp, "      \"symbols\": %zu,\n", Result.NumSymbols);
+        fprintf(fp, "      \"segments\": %zu,\n", Result.NumSegments);
+        fprintf(fp, "      \"triangles\": %lld,\n", Result.NumTriangles);
+        fprintf(fp, "      \"symbols_per_second\": %.1f,\n", Rate(static_cast<double>(Result.NumSymbols), Result.RewriteSeconds));
+        fprintf(fp, "      \"segments_per_second\": %.1f,\n", Rate(static_cast<double>(Result.NumSegments), Result.TurtleSeconds));
+        fprintf(fp, "      \"triangles_per_second\": %.1f,\n", Rate(static_cast<double>(Result.NumTriangles), Result.TurtleSeconds));
+        fprintf(fp, "      \"peak_rss_bytes\": %llu,\n", static_cast<unsigned long long>(Result.PeakResidentSet));
+        fprintf(fp, "      \"allocations\": %llu,\n", static_cast<unsigned long long>(Result.NumAllocations));
+        fprintf(fp, "      \"allocated_bytes\": %llu\n", static_cast<unsigned long long>(Result.AllocatedBytes));
+        fprintf(fp, "    }%s\n", i + 1 < Results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+    std::string Directory = "resource/systems/example";
+    const char* OutputFilename = "SystemBenchmark.json";
+    int ExtraIterations = 0;
+    int Repetitions = 3;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "-d") == 0)
+        {
+            Directory = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "-o") == 0)
+        {
+            OutputFilename = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "-e") == 0)
+        {
+            ExtraIterations = atoi(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "-r") == 0)
+        {
+            Repetitions = std::max(1, atoi(argv[i + 1]));
+        }
+    }
+
+    std::vector<std::string> SystemFilenames;
+    std::error_code Error;
+    for (const auto& File : std::filesystem::directory_iterator(Directory, Error))
+    {
+        if (File.is_regular_file())
+        {
+            SystemFilenames.push_back(File.path().string());
+        }
+    }
+    if (Error || SystemFilenames.empty())
+    {
+        fprintf(stderr, "no systems found in %s\n", Directory.c_str());
+        return EXIT_FAILURE;
+    }
+    std::sort(SystemFilenames.begin(), SystemFilenames.end());
+
+    //one turtle and triangle list for every case, as the application reuses them between generations
+    Turtle DrawingTurtle;
+    ColoredTriangleList* Triangles = nullptr;
+
+    std::vector<CaseResult> Results;
+    for (const std::string& Filename : SystemFilenames)
+    {
+        LSystem System;
+        System.LoadFromFile(Filename.c_str());
+        const int MaxIterations = System.GetIterations() + ExtraIterations;
+        const std::string SystemName = std::filesystem::path(Filename).filename().string();
+
+        for (int Iterations = 1; Iterations <= MaxIterations; Iterations++)
+        {
+            System.SetIterations(Iterations);
+            CaseResult Result = RunCase(System, DrawingTurtle, &Triangles, Repetitions);
+            Result.Name = SystemName + "/iterations:" + std::to_string(Iterations);
+
+            fprintf(stderr, "%-48s %10.3f ms %14.0f symbols/s %14.0f segments/s %14.0f triangles/s\n", Result.Name.c_str(),
+                    (Result.RewriteSeconds + Result.TurtleSeconds) * 1e3,
+                    Rate(static_cast<double>(Result.NumSymbols), Result.RewriteSeconds),
+                    Rate(static_cast<double>(Result.NumSegments), Result.TurtleSeconds),
+                    Rate(static_cast<double>(Result.NumTriangles), Result.TurtleSeconds));
+            Results.push_back(Result);
+        }
+    }
+    delete Triangles;
+
+    FILE* fp = fopen(OutputFilename, "w");
+    if (fp == nullptr)
+    {
+        fprintf(stderr, "could not write %s\n", OutputFilename);
+        return EXIT_FAILURE;
+    }
+    WriteJson(fp, Results);
+    fclose(fp);
+    fprintf(stderr, "wrote %zu cases to %s\n", Results.size(), OutputFilename);
+
+    return EXIT_SUCCESS;
+}
@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include "vec3.hpp"
+#include "lindenmayer/lindenmayer.h"
 
 class LSystem;
 class GLFWwindow;
@@ -18,6 +21,10 @@ public:
                               glm::vec3* AmbientColor,
                               float* AmbientStrength,
                               bool* bLitMode);
+    void SetForestVariables(bool* bForestMode,
+                            int* NumPlants,
+                            float* Radius,
+                            int* Seed);
 
     static void BeginFrame();
 
@@ -27,12 +34,20 @@ public:
 
     void (*UpdateCallback)() = nullptr;
     void (*LightUpdateCallback)() = nullptr;
+    void (*ForestUpdateCallback)() = nullptr;
+    void (*ForestAddSpeciesCallback)() = nullptr;
+    void (*ForestClearCallback)() = nullptr;
 
     void SetUpdateCallback(void (*UpdateCallbackSignature)());
     void SetLightUpdateCallback(void (*LightUpdateCallbackSignature)());
+    void SetForestCallbacks(void (*UpdateCallbackSignature)(),
+                            void (*AddSpeciesCallbackSignature)(),
+                            void (*ClearCallbackSignature)());
 
     void DrawSystemMenu(LSystem* ActiveSystem) const;
     void DrawLightMenu() const;
+    void DrawForestMenu(int NumSpecies, size_t NumPlants) const;
+    void DrawProfilerMenu(const char* TraceFilename) const;
 
     static void DrawMainMenuBar();
 
@@ -47,5 +62,21 @@ private:
         float* AmbientStrength = nullptr;
         bool* bLitMode = nullptr;
     } LightingInfo;
+
+    struct SForestInfo
+    {
+        bool* bForestMode = nullptr;
+        int* NumPlants = nullptr;
+        float* Radius = nullptr;
+        int* Seed = nullptr;
+    } ForestInfo;
+
+    //predicted generations of the system shown by DrawSystemMenu, predicted again when its content hash changes
+    mutable uint64_t StatsHash = 0;
+    mutable std::vector<LS_GenerationStats> GenerationStats;
+    mutable LS_GrowthPrediction CurrentGrowth;
+
+    //draws the predicted length and memory of every generation, and the symbols of the current one
+    void DrawGenerationStats(const LSystem* ActiveSystem) const;
 };
 
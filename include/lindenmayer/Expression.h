@@ -0,0 +1,94 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* LS_Constant
+ * A named value which can be referenced from any expression, i.e. define:R=1.456
+ */
+struct LS_Constant
+{
+    std::string Name;
+    float Value = 0.0f;
+};
+
+/* LS_Expression
+ * An arithmetic or logical expression over module parameters, such as "t+1" or "x>2 && y<1"
+ * Compiled once into a small stack-machine bytecode, so evaluating it while rewriting is a tight loop with no parsing
+ * Comparisons and logical operators produce 1.0 for true, 0.0 for false
+ */
+class LS_Expression
+{
+public:
+    LS_Expression()=default;
+
+    /** Compile
+     * Compiles the given source, resolving names to parameter slots or constants
+     * @param Source - the expression source
+     * @param ParameterNames - names of the parameters, the i-th name reads Parameters[i] during evaluation
+     * @param Constants - named constants, folded in at compile time
+     * @return true if the expression compiled successfully
+     */
+    bool Compile(const std::string& Source,
+                 const std::vector<std::string>& ParameterNames,
+                 const std::vector<LS_Constant>& Constants);
+
+    /** Evaluate
+     * @param Parameters - the parameter values, in the order of the names given to Compile
+     * @return the value of the expression
+     */
+    float Evaluate(const float* Parameters) const;
+
+    //whether the expression doesn't depend on any parameters
+    bool IsConstant() const { return Code.size() == 1 && Code[0].Op == EOpCode::Constant; }
+
+    //the source the expression was compiled from
+    const std::string& GetSource() const { return Source; }
+
+private:
+    enum class EOpCode : uint8_t
+    {
+        Constant,
+        Parameter,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        Negate,
+        Less,
+        Greater,
+        LessEqual,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        And,
+        Or,
+        Not,
+    };
+
+    struct Instruction
+    {
+        EOpCode Op = EOpCode::Constant;
+        uint8_t ParameterIndex = 0;
+        float Value = 0.0f;
+    };
+
+    //maximum depth of the evaluation stack
+    static constexpr int MaxStackDepth = 32;
+
+    //recursive descent parser, lowest to highest precedence
+    class Parser;
+
+    //appends an instruction, folding it into a constant if all of its operands are constants
+    void Emit(EOpCode Op, float Value = 0.0f, uint8_t ParameterIndex = 0);
+
+    static float Apply(EOpCode Op, float A, float B);
+
+    std::string Source;
+    std::vector<Instruction> Code;
+};
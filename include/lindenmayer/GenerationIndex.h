@@ -0,0 +1,106 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "lindenmayer/lindenmayer.h"
+
+/* LS_GenerationIndex
+ * Random access into a generation that is never expanded. Built once from the expansion length of every symbol at
+ * every depth, L(s, 0) = 1 and L(s, d) = the sum of L(t, d - 1) over the symbols t of s's successor, it finds the
+ * symbol at position k of generation N by descending the derivation tree from the axiom, skipping each subtree that
+ * ends before k by its length. Reading on from there walks the tree in order, so the substring [k, k + m) costs
+ * O(N + m) rather than the O(length) of rewriting, and lengths past 2^64 saturate rather than wrap.
+ *
+ * Only systems whose every symbol has at most one deterministic, unconditional, context-free rule can be indexed,
+ * as the length of anything else depends on where it is or what it holds. Parameters are evaluated along the path
+ * the descent takes. The index keeps its own copies of the axiom and successors, so it doesn't change with the
+ * system it was built from, and queries don't modify it, so workers can read separate ranges of it at once while the
+ * system is edited or rewritten
+ */
+class LS_GenerationIndex
+{
+public:
+    /** Build
+     * Indexes a generation of the system
+     * @param System - the system, whose rules are compiled if they've been edited
+     * @param Generation - the generation to index
+     * @return false if the system can't be indexed, leaving the index empty
+     */
+    bool Build(LSystem& System, int Generation);
+
+    //length of the indexed generation, UINT64_MAX if it's at least that long
+    uint64_t GetLength() const { return Generation < 0 ? 0 : GetExpansionLength(Axiom, Generation); }
+
+    int GetGeneration() const { return Generation; }
+
+    /** GetSymbol
+     * @param Position - position within the generation
+     * @return the symbol at Position, or '\0' if it's past the end
+     */
+    char GetSymbol(uint64_t Position) const;
+
+    /** GetSubstring
+     * Reads the symbols [Start, Start + Count) of the generation, clipped to its end
+     * @param Start - position of the first symbol
+     * @param Count - number of symbols to read
+     * @param Symbols - receives the symbols
+     * @param ParameterCounts - if not nullptr, receives the number of parameters of each symbol
+     * @param Parameters - if not nullptr, receives the parameters of every symbol, in order
+     * @return the number of symbols read
+     */
+    size_t GetSubstring(uint64_t Start, size_t Count, std::string& Symbols,
+                        std::vector<unsigned char>* ParameterCounts = nullptr,
+                        std::vector<float>* Parameters = nullptr) const;
+
+    //empties the index
+    void Clear();
+
+private:
+    /* Frame
+     * A level of the path from the axiom down to the current symbol, the module string its symbol was written by
+     * and the symbol's place in it. Symbols without a rule are copied into the next generation unchanged, which a
+     * frame without a module string stands for
+     */
+    struct Frame
+    {
+        const LS_ModuleString* Modules = nullptr;
+        uint32_t Index = 0;
+        uint32_t ParameterOffset = 0;
+        char Symbol = '\0';
+        int NumValues = 0;
+        float Values[MaxParameters] = {0};
+    };
+
+    //length of Symbol's expansion after Depth generations
+    uint64_t GetExpansionLength(const char Symbol, const int Depth) const
+    {
+        return Lengths[static_cast<size_t>(Depth) * 128 + (static_cast<unsigned char>(Symbol) & 127)];
+    }
+
+    //length of a module string's expansion after Depth generations
+    uint64_t GetExpansionLength(const LS_ModuleString& Modules, int Depth) const;
+
+    //points Frame at module Index of its string, evaluating its parameters against those of Parent
+    void LoadModule(Frame& Current, const Frame* Parent, uint32_t Index, uint32_t ParameterOffset) const;
+
+    //starts the frame below Parent at the first module of what Parent's symbol is rewritten to
+    void EnterSuccessor(Frame& Child, const Frame& Parent) const;
+
+    //moves the path to the next position of the generation, returning false past its end
+    bool Advance(std::vector<Frame>& Path) const;
+
+    //successor of each character, for the characters that are rewritten rather than copied unchanged
+    LS_ModuleString Successors[128];
+    bool bRewritten[128] = {false};
+
+    //expansion lengths, indexed by depth * 128 + character
+    std::vector<uint64_t> Lengths;
+
+    LS_ModuleString Axiom;
+    bool bParametric = false;
+    int Generation = -1;
+};
@@ -3,14 +3,308 @@
 //
 #pragma once
 
-#define MaxReplacementLength 48
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "lindenmayer/Expression.h"
+#include "utility/Arena.h"
+
+#define MaxNameLength 64
+#define MaxReplacementLength 128
+#define MaxPredecessorLength 64
+#define MaxSuccessors 8
+#define MaxParameters 8
+
+/* LS_ModuleString
+ * A string of modules, compiled into a symbol stream and a separate packed parameter stream
+ * i.e. "F(x*2)+(45)F" becomes the symbols "F+F", parameter counts {1, 1, 0}, and the expressions x*2, 45
+ */
+struct LS_ModuleString
+{
+    /** Compile
+     * @param Source - the module string
+     * @param ParameterNames - names parameter expressions may reference
+     * @param Constants - named constants parameter expressions may reference
+     * @return true if every parameter expression compiled successfully
+     */
+    bool Compile(const char* Source, const std::vector<std::string>& ParameterNames, const std::vector<LS_Constant>& Constants);
+
+    std::string Symbols;
+
+    //number of parameters of each symbol, empty unless the string is parametric
+    std::vector<unsigned char> ParameterCounts;
+
+    //parameter expressions of all symbols, in order
+    std::vector<LS_Expression> Parameters;
+
+    bool bParametric = false;
+};
+
+/* LS_Successor
+ * One alternative replacement string of a rewriting rule, along with its relative probability of being chosen
+ */
+struct LS_Successor
+{
+    float Weight = 1.0f;
+    char RString[MaxReplacementLength]={0};
+
+    //compiled form of RString, refreshed by LS_RewritingRule::Compile
+    LS_ModuleString Compiled;
+};
+
+/* LS_RewriteContext
+ * The string being rewritten, along with the indices used to find a module's neighbours in O(1)
+ * BracketMatch and ParameterOffsets are built once per generation, and only when context-sensitive rules exist
+ */
+struct LS_RewriteContext
+{
+    const char* Symbols = nullptr;
+    size_t Length = 0;
+
+    //parameter streams, ParameterCounts is nullptr for non-parametric strings
+    const unsigned char* ParameterCounts = nullptr;
+    const float* Parameters = nullptr;
+
+    //offset of each symbol's parameters into Parameters
+    const uint32_t* ParameterOffsets = nullptr;
+
+    //for every '[' the index of its matching ']' and vice versa, -1 for other symbols
+    const int* BracketMatch = nullptr;
+
+    //symbols skipped over when matching contexts, indexed by unsigned char
+    const bool* IgnoredSymbols = nullptr;
+};
+
+/* LS_BoundParameters
+ * Parameters of a module and its context, in the order a rule named them. Context-free rules point Values straight
+ * into the parameter stream, context-sensitive rules gather them into Storage
+ */
+struct LS_BoundParameters
+{
+    static constexpr int MaxBoundParameters = 4 * MaxParameters;
+
+    const float* Values = nullptr;
+    float Storage[MaxBoundParameters] = {0};
+};
+
+/** BuildBracketIndex
+ * For every '[' stores the index of its matching ']' and vice versa, -1 for unmatched brackets and other symbols
+ * @param Symbols - the string to index
+ * @param Length - length of the string
+ * @param BracketMatch - receives the index, resized to Length
+ */
+void BuildBracketIndex(const char* Symbols, size_t Length, std::vector<int>& BracketMatch);
+
+/* LS_RewritingRule
+ * A production, replacing a predecessor module with a successor. Parametric rules name the predecessor's parameters,
+ * i.e. A(t), and may only apply when a condition over them holds, i.e. t>5. Deterministic rules have one successor,
+ * stochastic rules have several weighted successors, one of which is picked per application using an alias table.
+ * Context-sensitive rules also name the modules to the left and right of the predecessor, i.e. B<A>C. The left
+ * context is the path back towards the root, the right context may branch itself, i.e. A>B[C]D
+ */
 struct LS_RewritingRule
 {
-    LS_RewritingRule() : LS_RewritingRule(' ', ""){}
-    LS_RewritingRule(char c, const char* R);
+    LS_RewritingRule() = default;
+    LS_RewritingRule(const char* PredecessorString, const char* Condition);
+
+    /** SetSuccessor
+     * Replaces all successors with the single, deterministic successor R
+     */
+    void SetSuccessor(const char* R);
+
+    /** AddSuccessor
+     * Adds a weighted alternative successor, making the rule stochastic
+     * @return false if the rule already holds MaxSuccessors alternatives
+     */
+    bool AddSuccessor(const char* R, float Weight);
+
+    /** Compile
+     * Compiles the predecessor, condition and successor strings and rebuilds the alias table,
+     * call after any of them change
+     * @param Constants - named constants expressions may reference
+     * @return true if the rule compiled successfully, rules which failed to compile never match
+     */
+    bool Compile(const std::vector<LS_Constant>& Constants);
+
+    /** BuildAliasTable
+     * Recomputes the alias table used by SelectSuccessor
+     */
+    void BuildAliasTable();
+
+    /** Matches
+     * Whether the rule applies to the module at Index, binding the parameters its condition and successors use
+     * @param Context - the string being rewritten
+     * @param Index - index of the module in the string
+     * @param Parameters - the module's parameters
+     * @param NumParameters - the number of parameters of the module
+     * @param Bound - receives the bound parameters of the module and its context
+     */
+    bool Matches(const LS_RewriteContext& Context, size_t Index, const float* Parameters, int NumParameters, LS_BoundParameters& Bound) const
+    {
+        if (!bCompiled || NumParameters != NumPredecessorParameters)
+        {
+            return false;
+        }
+
+        if (!bContextSensitive)
+        {
+            Bound.Values = Parameters;
+        }
+        else if (!MatchContext(Context, Index, Parameters, Bound))
+        {
+            return false;
+        }
+
+        return !bConditional || Condition.Evaluate(Bound.Values) != 0.0f;
+    }
 
+    /** SelectSuccessor
+     * Picks a successor in O(1) using the alias table
+     * @param Random - 64 uniformly distributed random bits
+     */
+    const LS_Successor& SelectSuccessor(uint64_t Random) const
+    {
+        const uint32_t Column = static_cast<uint32_t>(((Random >> 32) * static_cast<uint64_t>(NumSuccessors)) >> 32);
+        const uint32_t Coin = static_cast<uint32_t>(Random);
+        return Successors[Coin < AliasThreshold[Column] ? Column : AliasIndex[Column]];
+    }
+
+    //character being rewritten
     char Character = ' ';
-    char RString[MaxReplacementLength]={0};
+
+    //predecessor module, i.e. "A", "A(x,y)", or with left and right contexts "B(y)<A(x)>C"
+    char PredecessorString[MaxPredecessorLength] = {0};
+
+    //condition which must hold for the rule to apply, empty if the rule is unconditional
+    char ConditionString[MaxReplacementLength] = {0};
+
+    //whether successors were given explicit weights, rather than a single deterministic replacement
+    bool bStochastic = false;
+
+    int NumSuccessors = 0;
+    LS_Successor Successors[MaxSuccessors];
+
+    //alias table, column i keeps successor i with probability AliasThreshold[i] / 2^32, otherwise AliasIndex[i]
+    uint32_t AliasThreshold[MaxSuccessors] = {0};
+    unsigned char AliasIndex[MaxSuccessors] = {0};
+
+    //compiled predecessor and condition
+    bool bCompiled = false;
+    bool bConditional = false;
+    bool bContextSensitive = false;
+    int NumPredecessorParameters = 0;
+
+    //parameter names of the left context, predecessor, and right context, in that order
+    std::vector<std::string> FormalNames;
+    LS_Expression Condition;
+
+    //context modules, along with the number of parameters each must have
+    std::string LeftContext;
+    std::vector<unsigned char> LeftContextCounts;
+    std::string RightContext;
+    std::vector<unsigned char> RightContextCounts;
+    int NumLeftContextParameters = 0;
+
+protected:
+    /** MatchContext
+     * Matches the left and right contexts around the module at Index, skipping over branches and ignored symbols
+     */
+    bool MatchContext(const LS_RewriteContext& Context, size_t Index, const float* Parameters, LS_BoundParameters& Bound) const;
+};
+
+/* LS_PrimitiveSizes
+ * What the turtle and the renderer make of each primitive of a generation, which predictions turn counts into
+ * triangles and bytes with. Rewriting doesn't depend on either, so whoever draws the systems fills these in with
+ * LSystem::SetPrimitiveSizes. Left at their defaults, predictions count the string alone
+ */
+struct LS_PrimitiveSizes
+{
+    //triangles the turtle draws per segment, and per segment uploaded at every level of detail together
+    double TrianglesPerSegment = 0.0;
+    double UploadedTrianglesPerSegment = 0.0;
+
+    //bytes of a turtle triangle, a turtle segment and an uploaded vertex
+    double TriangleBytes = 0.0;
+    double SegmentBytes = 0.0;
+    double VertexBytes = 0.0;
+
+    //bytes the vertex buffer allocates per byte of vertices uploaded to it
+    double VertexBufferOverhead = 1.0;
+
+    //most triangles the turtle draws, a generation with more is truncated
+    double MaxTriangles = INFINITY;
+};
+
+/* LS_GenerationStats
+ * What one generation of a system holds, predicted from its rules without rewriting. Symbol counts follow the
+ * production matrix, counts(n+1) = M * counts(n), where M holds how many of each symbol a symbol's successor writes.
+ * Stochastic rules contribute the weighted average of their successors. A character whose rewriting depends on a
+ * condition or a context is predicted with its first unconditional, context-free rule, or its first rule if it has
+ * none, so its counts are an estimate
+ */
+struct LS_GenerationStats
+{
+    int Iteration = 0;
+
+    //expected number of each symbol, indexed by character
+    double SymbolCounts[128] = {0};
+    double Length = 0.0;
+
+    //deepest nesting of branches, an upper bound when stochastic successors nest differently
+    long long MaxBracketDepth = 0;
+
+    //segments drawn by F and G, and triangles of their cones and of polygons, an upper bound for polygons whose
+    //vertices coincide
+    double NumSegments = 0.0;
+    double NumTriangles = 0.0;
+
+    //bytes of the string and its parameters, of the turtle's triangles and segments, and of the vertex buffer
+    //allocated for the vertices at every level of detail
+    double StringBytes = 0.0;
+    double GeometryBytes = 0.0;
+    double VertexBytes = 0.0;
+
+    //whether the counts are exact, every rule applied being deterministic, context-free and unconditional
+    bool bExact = true;
+
+    //whether the generation is longer than Rewrite, or has more triangles than the turtle, can hold
+    bool bTruncated = false;
+
+    double GetTotalBytes() const { return StringBytes + GeometryBytes + VertexBytes; }
+};
+
+/* LS_GrowthPrediction
+ * Prediction of a single, possibly distant, generation, fast-forwarded by raising the production matrix to the
+ * generation's power with repeated squaring. Sizes are kept as base 2 logarithms, as they outgrow a double long
+ * before the iteration count outgrows an int. Estimates follow the same rules as LS_GenerationStats
+ */
+struct LS_GrowthPrediction
+{
+    int Iteration = 0;
+
+    //base 2 logarithms of the expected number of each symbol, -infinity for symbols that never appear
+    double Log2SymbolCounts[128];
+    double Log2Length = -INFINITY;
+    double Log2NumSegments = -INFINITY;
+    double Log2NumTriangles = -INFINITY;
+    double Log2TotalBytes = -INFINITY;
+
+    //base 2 logarithm of the symbols written by every rewrite up to this generation
+    double Log2RewrittenSymbols = -INFINITY;
+
+    //factor the string grows by each generation in the long run, the largest eigenvalue of the production matrix
+    double GrowthRate = 1.0;
+
+    //seconds rewriting up to this generation should take, at the rate the last rewrite ran at
+    double EstimatedRewriteSeconds = 0.0;
+
+    bool bExact = true;
+    bool bTruncated = false;
+
+    //sizes as plain numbers, infinity once they outgrow a double
+    double GetLength() const { return exp2(Log2Length); }
+    double GetTotalBytes() const { return exp2(Log2TotalBytes); }
 };
 
 /* LSystem
@@ -24,7 +318,14 @@ class LSystem
 {
   friend class UIManager;
   friend class Turtle;
+  friend class LS_GenerationIndex;
 public:
+    //longest string Rewrite generates, the rest of a generation past it is dropped
+    static constexpr size_t MaxGeneratedLength = 1000000;
+
+    //iterations below the requested one GetLargestIterationWithin tries one by one
+    static constexpr int MaxScannedIterations = 1024;
+
     LSystem();
 
     /** SetName
@@ -34,18 +335,58 @@ public:
 
     /** AddRule
      * Adds a rewriting rule to the L-System, for when the given character is read, it is replaced with RewrittenString
+     * IF a rule already exists, it will be overwritten
      * @param character - the character to be rewritten
      * @param RewrittenString - the string the character should be replaced with
      */
     void AddRule(char character, const char* RewrittenString);
 
+    /** AddRule
+     * Adds a, possibly parametric and conditional, rewriting rule to the L-System
+     * IF a rule with the same predecessor and condition already exists, it will be overwritten
+     * @param Predecessor - the module to be rewritten, i.e. "A(t)"
+     * @param Condition - condition over the predecessor's parameters, i.e. "t>5", or nullptr
+     * @param RewrittenString - the string the module should be replaced with, i.e. "B(t+1)C"
+     */
+    void AddRule(const char* Predecessor, const char* Condition, const char* RewrittenString);
+
+    /** AddStochasticRule
+     * Adds a weighted alternative for the given predecessor. Each time the rule applies, the module is replaced by one
+     * of its alternatives, chosen with probability proportional to its weight
+     * @param Predecessor - the module to be rewritten
+     * @param Condition - condition over the predecessor's parameters, or nullptr
+     * @param RewrittenString - one possible replacement
+     * @param Weight - relative probability of this replacement
+     */
+    void AddStochasticRule(const char* Predecessor, const char* Condition, const char* RewrittenString, float Weight);
+
     /** AddRuleFromString
      * Adds a rewriting rule from the given string. The provided string should be in the format C:RWRULE,
      * where C is the character we're creating a rule for, and RWRULE is the string which replaces it.
      * IF a rule already exists, it will be overwritten
+     * The general format is PRED[:COND][-(W)]->RWRULE, i.e. A(t):t>5->B(t+1)C, where W is the weight of a
+     * stochastic alternative
      */
      void AddRuleFromString(const char* String);
 
+    /** HasRule
+     * @return whether any rule rewrites the given character
+     */
+    bool HasRule(char character) const;
+
+    /** AddConstant
+     * Adds a named constant which rule conditions and parameters may reference, overwriting an existing one
+     * @param ConstantName - the name of the constant
+     * @param Value - the value of the constant
+     */
+    void AddConstant(const char* ConstantName, float Value);
+
+    /** SetIgnoredSymbols
+     * Sets the symbols skipped over when matching the contexts of context-sensitive rules, i.e. "+-F"
+     * @param Symbols - the symbols to ignore
+     */
+    void SetIgnoredSymbols(const char* Symbols);
+
     /** SetAxiom
      * Sets the initial string, or starting point, of the L-System
      * @param NewAxiom - the new axiom string
@@ -53,10 +394,24 @@ public:
     void SetAxiom(const char* NewAxiom);
 
     /** SetIterations
-     * Sets the number of iterations to be run when Rewrite is called
+     * Sets the number of iterations to be run when Rewrite is called, lowered to the most that fit in the memory
+     * budget if there is one
      * @param NewIterations - the new number of iterations
+     * @return the number of iterations set
      */
-    void SetIterations(int NewIterations);
+    int SetIterations(int NewIterations);
+
+    /** SetMemoryBudget
+     * Limits the memory a generation may use, as predicted by PredictGeneration, which SetIterations and
+     * LoadFromFile enforce by lowering the iteration count
+     * @param Bytes - the budget, 0 for none
+     */
+    void SetMemoryBudget(size_t Bytes);
+
+    /** GetIterations
+     * @return the number of iterations run when Rewrite is called
+     */
+    int GetIterations() const { return Iterations; }
 
     /** SetAngle
      * Sets the Angle to rotate
@@ -70,6 +425,12 @@ public:
      */
     void SetDistance(float NewDistance);
 
+    /** SetSeed
+     * Sets the seed stochastic rules are evaluated with. The same seed always produces the same string
+     * @param NewSeed - the new seed
+     */
+    void SetSeed(uint32_t NewSeed);
+
     /** LoadFromFile
      * Load L-System settings from a file
      * @param Filename
@@ -82,30 +443,145 @@ public:
      */
     void SaveToFile(const char* Filename);
 
+    /** GetContentHash
+     * Hashes everything that decides what the system generates, its axiom, constants, rules, iterations, angle,
+     * distance and seed, but not its name. Systems with the same hash draw the same model
+     * @return 64 bit FNV-1a hash of the system
+     */
+    uint64_t GetContentHash() const;
+
     void Rewrite();
     void Reset();
 
+    /** PredictGenerations
+     * Predicts generations 0 through NumGenerations from the rules alone, in time proportional to the number of
+     * generations and the size of the rules rather than of the strings they'd generate
+     * @param NumGenerations - last generation to predict
+     * @param Stats - receives NumGenerations + 1 predictions, one per generation
+     */
+    void PredictGenerations(int NumGenerations, std::vector<LS_GenerationStats>& Stats);
+
+    /** PredictGeneration
+     * Predicts a single generation by fast-forwarding the production matrix, in time logarithmic in the iteration, so
+     * it answers for iteration counts far past anything Rewrite could generate. Counts of deterministic context-free
+     * systems are exact while they fit in a double's 53 bit mantissa
+     * @param Iteration - the generation to predict
+     */
+    LS_GrowthPrediction PredictGeneration(int Iteration);
+
+    /** SetPrimitiveSizes
+     * Sets the sizes every system's predictions count triangles and bytes with
+     */
+    static void SetPrimitiveSizes(const LS_PrimitiveSizes& Sizes);
+
+    /** GetLargestIterationWithin
+     * Tries the MaxScannedIterations iterations up to MaxIteration one by one, as generations can shrink as well as
+     * grow, then bisects below them assuming growth, where the answer is only a lower bound
+     * @param Bytes - memory the generation may use
+     * @param MaxIteration - the most iterations to consider
+     * @return the largest iteration up to MaxIteration predicted to fit in Bytes, or 0 if none does
+     */
+    int GetLargestIterationWithin(size_t Bytes, int MaxIteration);
+
+    /** GetOutputString
+     * @return the generated symbols, or the axiom if the system has not been rewritten
+     */
+    const char* GetOutputString() const;
+
+    /** GetOutputParameterCounts
+     * @return the number of parameters of each generated symbol, or nullptr if the output isn't parametric
+     */
+    const unsigned char* GetOutputParameterCounts() const;
+
+    /** GetOutputParameters
+     * @return the packed parameters of all generated symbols, in order
+     */
+    const float* GetOutputParameters() const;
+
 protected:
 
+    /** CompileRules
+     * compiles the axiom and all rules, which may have been edited in place since they were added
+     */
+    void CompileRules();
+
+    /** FindRule
+     * @return the rule with the given predecessor and condition, or nullptr
+     */
+    LS_RewritingRule* FindRule(const char* Predecessor, const char* Condition);
+
+    /** FindOrAddRule
+     * @return the rule with the given predecessor and condition, added if it doesn't exist
+     */
+    LS_RewritingRule& FindOrAddRule(const char* Predecessor, const char* Condition);
+
     //name of the system
-    char* Name = nullptr;
+    char Name[MaxNameLength] = {0};
 
     //initial string which rewriting works off of
-    char* Axiom = nullptr;
+    char Axiom[MaxReplacementLength] = {0};
 
     //the generated string from a number of rewritings, is used as an intermediary if multiple iterations occur
     char* GeneratedString = nullptr;
 
+    //memory for generated strings and the rewriting buffer, released all at once by Reset. Once it has grown to fit
+    //a system, regenerating it doesn't allocate
+    Arena GenerationArena;
+
+    //parameters of each generated symbol, used when the system is parametric
+    std::vector<unsigned char> GeneratedParameterCounts;
+    std::vector<float> GeneratedParameters;
+
+    //working buffers for parameters, kept around so their storage is reused between rewrites
+    std::vector<unsigned char> WorkingParameterCounts;
+    std::vector<float> WorkingParameters;
+
     //rules for rewriting the axiom or generated string for each iteration of rewriting
-    LS_RewritingRule RewritingRules[128];
+    std::vector<LS_RewritingRule> RewritingRules;
+
+    //indices into RewritingRules by predecessor character, rebuilt by CompileRules. Context-sensitive rules are
+    //tried first, then the rest in the order they were added, and the first matching rule applies
+    std::vector<int> RuleLookup[128];
+
+    //whether any rule has a left or right context, requiring the bracket index to be built while rewriting
+    bool bContextSensitive = false;
+
+    //symbols skipped over when matching contexts
+    std::string IgnoredSymbolsString;
+    bool IgnoredSymbols[256] = {false};
+
+    //per generation indices into the string being rewritten, kept around so their storage is reused
+    std::vector<int> BracketMatch;
+    std::vector<uint32_t> ParameterOffsets;
+
+    //named constants available to rule conditions and parameters
+    std::vector<LS_Constant> Constants;
+
+    //compiled axiom, the starting point of rewriting
+    LS_ModuleString CompiledAxiom;
+
+    //whether the axiom or any rule carries parameters
+    bool bParametric = false;
 
     //the number of times the string should be rewritten, using the rewriting rules provided
     int Iterations = 1.0f;
 
+    //most memory a generation may be predicted to use, 0 for no limit
+    size_t MemoryBudget = 0;
+
+    //symbols written per second by the last rewrite long enough to time, shared by every system to estimate rewrites
+    static double RewriteSymbolsPerSecond;
+
+    //sizes of what the turtle and renderer make of each primitive, shared by every system's predictions
+    static LS_PrimitiveSizes PrimitiveSizes;
+
     //the distance a turtle should move when a move command is read
     float Distance = 1.0f;
 
     //the angle a turtle should rotate when a rotation command is read
     float Angle = 90.0f;
+
+    //seed for stochastic rules, each choice is keyed on (Seed, iteration, position) so it's independent of evaluation order
+    uint32_t Seed = 0;
 };
 
@@ -13,9 +13,15 @@
 
 //LSYS
 #include "rendering/Camera.h"
+#include "rendering/ChunkBVH.h"
+#include "rendering/GPUTimer.h"
+#include "rendering/RenderingContext.h"
 #include "lindenmayer/lindenmayer.h"
+#include "scene/Forest.h"
+#include "scene/GenerationCache.h"
 #include "utility/Transform.h"
 #include "utility/Turtle.h"
+#include "utility/Arena.h"
 
 //UI Manager
 #include "UI/UIManager.h"
@@ -40,9 +46,24 @@ bool InitLSystems();
 //run the program, which loops updating time, ticking, rendering, and processing input
 void Run();
 
+//marks the frame as changed, so the next few frames are drawn when rendering on demand
+void RequestRedraw();
+//whether anything is moving on its own, in which case the loop keeps polling instead of waiting for events
+bool IsAnimating();
+
 void UpdateTiming(GLFWwindow* window);
 void UpdateVertexBuffers();
 void UpdateLightData();
+void CacheUniformLocations();
+
+//forest mode, scattering the plants again after its settings change
+void UpdateForest();
+//adds the current model as a forest species
+void AddForestSpecies();
+//removes every forest species
+void ClearForest();
+//uploads the placements of predefined surfaces, the forest's in forest mode and the model's otherwise
+void UploadSurfaceInstances();
 
 void Tick(double DeltaTime);
 void Render(double DeltaTime);
@@ -56,6 +77,10 @@ void KeyboardEventCallback(GLFWwindow* Window, int KeyCode, int ScanCode, int Ac
 void MouseMoveEventCallback(GLFWwindow* Window, double xPos, double yPos);
 void MouseButtonEventCallback(GLFWwindow* Window, int button, int action, int mods);
 void MouseScrollEventCallback(GLFWwindow* Window, double xOffset, double yOffset);
+//text input callback, forwarded to ImGui
+void CharEventCallback(GLFWwindow* Window, unsigned int Codepoint);
+//window contents damaged callback function
+void WindowRefreshEventCallback(GLFWwindow* Window);
 //window resize event callback function
 void WindowResizeEventCallback(GLFWwindow* Window, int NewWidth, int NewHeight);
 //error callback function
@@ -132,23 +157,44 @@ static unsigned int FrameCount = 0;
 //exit flag
 static bool bRequestedExit = false;
 
+//when set, frames are only drawn after the camera, model, lighting or UI change, and the loop sleeps otherwise
+static bool bRenderOnDemand = true;
+//frames still to be drawn, a change draws a few so ImGui widgets that respond a frame late can settle
+static int PendingRedrawFrames = 0;
+constexpr int RedrawFramesPerChange = 3;
+//longest sleep waiting for events while idle, in seconds, so a text caret still blinks
+constexpr double IdleWaitTimeout = 0.5;
+
 //initialization flags
 static bool bGLFWInitialized = false;
 
-//Active L-System and Active Turtle
+//Active L-System and its model, shared through the GenerationCache with any forest species drawing the same system
 LSystem ActiveSystem;
-Turtle ActiveTurtle;
-ColoredTriangleList* TriangleList = nullptr;
+std::shared_ptr<const Scene::GeneratedModel> ActiveModel;
+//offset the model is drawn at, centering it vertically
+glm::vec3 ActiveModelOffset = glm::vec3(0.0f);
+
+//forest mode draws many plants of a few species, each a snapshot of a generated model, instead of the single model
+Scene::Forest Forest;
+bool bForestMode = false;
+//scene file naming the forest's species, from the command line
+const char* ForestSceneFilename = nullptr;
+int ForestNumPlants = 500;
+float ForestRadius = 40.0f;
+int ForestSeed = 1;
+
+//spatial chunks of TriangleList, in the order its vertices are uploaded, culled against the camera every frame
+Rendering::ChunkBVH ModelChunks;
+
+//scratch memory for building light vertex data before it is uploaded, reset at the start of every upload
+Arena UploadArena;
 
 //field of vision
 constexpr double FoV_y_degrees = 50;
 constexpr double FoV_y = glm::radians(FoV_y_degrees);
 
 //colored triangle vao/vbo etc.
-GLuint ColoredVertexArrayObject;
-GLuint ColoredVertexBufferObject_Positions;
-GLuint ColoredVertexBufferObject_Colors;
-GLuint ColoredVertexBufferObject_Normals;
+Rendering::RenderingContext RenderContext;
 
 //axes triangle vao/vbo etc.
 GLuint AxesVAO;
@@ -171,5 +217,17 @@ int LightVertCount = 0;
 //whether the L-system model is rendered with lighting (HardCodedLightShaderProgram) or flat-shaded (PassthroughShaderProgram)
 bool bLitMode = true;
 
+//per program uniform locations, refreshed from the programs' caches whenever they're linked
+GLint LitTwoSidedLocation = -1;
+GLint SurfaceLitModeLocation = -1;
+GLint ForestTwoSidedLocation = -1;
+
+//gpu time of drawing the scene and the UI, reported to the profiler
+Rendering::GPUTimer SceneGPUTimer;
+Rendering::GPUTimer UIGPUTimer;
+
+//file the profiler's captures are written to
+constexpr const char* ProfilerTraceFilename = "lsys_trace.json";
+
 //UI manager
 UIManager UI;
@@ -30,6 +30,7 @@ public:
     void SetClipFar(double Far);
 
     const glm::mat4& GetProjectionMatrix() const;
+    glm::mat4 GetViewMatrix();
     glm::mat4 GetViewProjectionMatrix();
 
 protected:
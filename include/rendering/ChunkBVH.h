@@ -0,0 +1,133 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "rendering/ColoredTriangle.h"
+#include "rendering/ConeSegment.h"
+#include "rendering/Frustum.h"
+
+namespace Rendering
+{
+    struct VertexLayout;
+
+    /* ChunkBVH
+     * Bounding volume hierarchy over the model, splitting it at the median of its primitives' centers along the
+     * longest axis until chunks of at most LeafSize primitives remain. Primitives are the turtle's segments, and the
+     * triangles of its polygons. The model is uploaded in the hierarchy's order, so every node covers one contiguous
+     * range of vertices, and a node wholly inside the view is drawn without looking at its children.
+     *
+     * Segments are uploaded once per level of detail, each level drawing their cones with fewer sides. Every chunk
+     * is drawn at the coarsest level whose cones stray no more than MaxScreenError pixels from the true surface.
+     * One sided and two sided triangles get separate hierarchies, as they're drawn apart
+     */
+    class ChunkBVH
+    {
+    public:
+        static constexpr uint32_t LeafSize = 128;
+
+        //sides of the segments' cones at each level of detail, the first being the turtle's own triangles
+        static constexpr int NumLevels = 3;
+        static constexpr int LevelSides[NumLevels] = {ConeSegment::FullDetailSides, 5, 3};
+
+        //largest error, in pixels, allowed when drawing segments with fewer sides, 0 always draws full detail
+        float MaxScreenError = 1.0f;
+
+        /** ChunkBVH::Build
+         * @param List - the model's triangles, one sided ones before FirstTwoSidedTriangle
+         * @param Segments - the segments the one sided triangles were drawn from, in the same order
+         * @param Offset - offset applied to every vertex when it's uploaded
+         */
+        void Build(const ColoredTriangleList& List, const std::vector<ConeSegment>& Segments, const glm::vec3& Offset);
+
+        //removes every chunk, after which nothing is drawn
+        void Clear();
+
+        //number of vertices written by WriteVertices, over every level of detail
+        size_t GetNumVertices() const { return NumVertices; }
+
+        /** ChunkBVH::WriteVertices
+         * Writes every level of detail of the model, in the order DrawVisible expects it
+         * @param Vertices - GetNumVertices vertices to fill in
+         */
+        void WriteVertices(VertexLayout* Vertices) const;
+
+        /** ChunkBVH::DrawVisible
+         * Draws the chunks inside or crossing ViewFrustum with one glMultiDrawArrays, the model's vertex array bound
+         * @param ViewFrustum - the camera's frustum
+         * @param ViewportHeight - height of the view in pixels, to measure errors in
+         * @param bTwoSided - whether to draw the two sided triangles rather than the one sided ones
+         * @return number of triangles drawn
+         */
+        uint32_t DrawVisible(const Frustum& ViewFrustum, float ViewportHeight, bool bTwoSided);
+
+        //number of leaf chunks over both hierarchies
+        uint32_t GetNumChunks() const { return NumLeaves; }
+
+    private:
+        struct Node
+        {
+            glm::vec3 BoundsMin;
+            uint32_t FirstPrimitive;
+            glm::vec3 BoundsMax;
+            uint32_t NumPrimitives;
+            //the left child always follows its parent, -1 for leaves
+            int32_t RightChild;
+            //widest segment radius within the node, which bounds the error of its coarser levels
+            float MaxRadius;
+        };
+
+        /* Hierarchy
+         * One of the two trees, with where each of its levels of detail is uploaded
+         */
+        struct Hierarchy
+        {
+            int32_t Root = -1;
+            //position of its first primitive in PrimitiveOrder
+            uint32_t FirstPrimitive = 0;
+            int NumDetailLevels = 1;
+            uint32_t TrianglesPerPrimitive[NumLevels] = {1};
+            uint32_t FirstVertex[NumLevels] = {0};
+        };
+
+        //builds the subtree over PrimitiveOrder[First, First + Count), returning its root
+        int32_t BuildNode(uint32_t First, uint32_t Count);
+
+        //coarsest level for which a segment of Radius at Depth strays no more than MaxScreenError pixels
+        int SelectLevel(const Hierarchy& Tree, float Radius, float Depth, float PixelScale) const;
+
+        //appends the vertices of a node at a level to the ranges to draw, merging it with the previous range if they touch
+        void AddDrawRange(const Hierarchy& Tree, const Node& Range, int Level);
+
+        //writes the triangles of a primitive at a level of detail, returning the vertex after them. Coarser levels of
+        //segments are triangulated into Scratch, which has room for a cone of ConeSegment::MaxSides
+        VertexLayout* WritePrimitive(const Hierarchy& Tree, uint32_t Primitive, int Level, ColoredTriangle* Scratch,
+                                     VertexLayout* Vertices) const;
+
+        const ColoredTriangleList* SourceList = nullptr;
+        const std::vector<ConeSegment>* SourceSegments = nullptr;
+        glm::vec3 VertexOffset = glm::vec3(0.0f);
+
+        //primitives in upload order. One sided primitives, segments or triangles if there are no segments, are
+        //numbered from 0 and two sided triangles after them. Bounds and radii are indexed by those numbers
+        std::vector<uint32_t> PrimitiveOrder;
+        std::vector<glm::vec3> PrimitiveBoundsMin;
+        std::vector<glm::vec3> PrimitiveBoundsMax;
+        std::vector<float> PrimitiveRadii;
+        bool bHasSegments = false;
+
+        std::vector<Node> Nodes;
+        Hierarchy OneSided;
+        Hierarchy TwoSided;
+        uint32_t NumLeaves = 0;
+        size_t NumVertices = 0;
+
+        //vertex ranges passed to glMultiDrawArrays, kept to reuse their storage every frame
+        std::vector<int> DrawFirsts;
+        std::vector<int> DrawCounts;
+    };
+}
@@ -73,11 +73,15 @@ struct ColoredTriangleList
     void Clear()
     {
         NumTriangles = 0;
+        FirstTwoSidedTriangle = 0;
     }
 
     long long int NumTriangles = 0;
     long long int MaxTriangles = 0;
 
+    //triangles from here on are visible from both sides, and are drawn without back face culling
+    long long int FirstTwoSidedTriangle = 0;
+
     static constexpr float FLOAT_MIN = 1.175494351E-38;
     static constexpr float FLOAT_MAX = 3.402823466E+38;
     glm::vec3 BoundingBoxMin = glm::vec3(FLOAT_MAX);
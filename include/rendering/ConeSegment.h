@@ -0,0 +1,37 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include "rendering/ColoredTriangle.h"
+
+/* ConeSegment
+ * A segment drawn by the turtle, a cone tapering from its start to its end radius, kept alongside its triangles so
+ * it can be drawn again with fewer sides for distant levels of detail
+ */
+struct ConeSegment
+{
+    //sides of the cones in the turtle's triangle list
+    static constexpr int FullDetailSides = 11;
+    static constexpr int MaxSides = FullDetailSides;
+
+    glm::vec3 Start;
+    float StartRadius;
+    glm::vec3 End;
+    float EndRadius;
+    glm::vec3 Right;
+    glm::vec3 Up;
+    glm::vec3 StartColor;
+    glm::vec3 EndColor;
+
+    /** ConeSegment::Triangulate
+     * @param NumSides - sides around the cone, at most MaxSides
+     * @param Triangles - receives 2 * NumSides triangles, two per side
+     */
+    void Triangulate(int NumSides, ColoredTriangle* Triangles) const;
+
+    //largest distance of the surface from the segment's axis
+    float GetMaxRadius() const { return StartRadius > EndRadius ? StartRadius : EndRadius; }
+};
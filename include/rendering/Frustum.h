@@ -0,0 +1,93 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Rendering
+{
+    enum class EFrustumTest
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    /* Frustum
+     * The six clip planes of a view projection matrix, in world space, with normals pointing into the volume seen
+     */
+    struct Frustum
+    {
+        explicit Frustum(const glm::mat4& ViewProjectionMatrix)
+        {
+            //each plane is the sum or difference of the w row and one of the x, y or z rows of the matrix
+            const glm::vec4 RowX(ViewProjectionMatrix[0][0], ViewProjectionMatrix[1][0], ViewProjectionMatrix[2][0], ViewProjectionMatrix[3][0]);
+            const glm::vec4 RowY(ViewProjectionMatrix[0][1], ViewProjectionMatrix[1][1], ViewProjectionMatrix[2][1], ViewProjectionMatrix[3][1]);
+            const glm::vec4 RowZ(ViewProjectionMatrix[0][2], ViewProjectionMatrix[1][2], ViewProjectionMatrix[2][2], ViewProjectionMatrix[3][2]);
+            const glm::vec4 RowW(ViewProjectionMatrix[0][3], ViewProjectionMatrix[1][3], ViewProjectionMatrix[2][3], ViewProjectionMatrix[3][3]);
+            Planes[0] = RowW + RowX;
+            Planes[1] = RowW - RowX;
+            Planes[2] = RowW + RowY;
+            Planes[3] = RowW - RowY;
+            Planes[4] = RowW + RowZ;
+            Planes[5] = RowW - RowZ;
+            DepthRow = RowW;
+            VerticalScale = glm::length(glm::vec3(RowY));
+        }
+
+        //distance of a point in front of the camera, which projection divides by, for perspective projections
+        float GetDepth(const glm::vec3& Point) const { return glm::dot(glm::vec3(DepthRow), Point) + DepthRow.w; }
+
+        /** Frustum::GetDepthRange
+         * @param BoundsMin - minimum corner of an axis aligned box
+         * @param BoundsMax - maximum corner of the box
+         * @param OutNear - receives the smallest depth of any point in the box's bounding sphere
+         * @param OutFar - receives the largest depth
+         */
+        void GetDepthRange(const glm::vec3& BoundsMin, const glm::vec3& BoundsMax, float& OutNear, float& OutFar) const
+        {
+            const float Depth = GetDepth((BoundsMin + BoundsMax) * 0.5f);
+            const float Spread = glm::length(BoundsMax - BoundsMin) * 0.5f * glm::length(glm::vec3(DepthRow));
+            OutNear = Depth - Spread;
+            OutFar = Depth + Spread;
+        }
+
+        /** Frustum::TestBox
+         * @param BoundsMin - minimum corner of an axis aligned box
+         * @param BoundsMax - maximum corner of the box
+         * @return whether the box is entirely outside the frustum, entirely inside it, or crossing its planes
+         */
+        EFrustumTest TestBox(const glm::vec3& BoundsMin, const glm::vec3& BoundsMax) const
+        {
+            EFrustumTest Result = EFrustumTest::Inside;
+            for (const glm::vec4& Plane : Planes)
+            {
+                //the corners furthest along and furthest against the plane's normal
+                const glm::vec3 Furthest(Plane.x >= 0 ? BoundsMax.x : BoundsMin.x,
+                                         Plane.y >= 0 ? BoundsMax.y : BoundsMin.y,
+                                         Plane.z >= 0 ? BoundsMax.z : BoundsMin.z);
+                const glm::vec3 Nearest(Plane.x >= 0 ? BoundsMin.x : BoundsMax.x,
+                                        Plane.y >= 0 ? BoundsMin.y : BoundsMax.y,
+                                        Plane.z >= 0 ? BoundsMin.z : BoundsMax.z);
+                if (glm::dot(glm::vec3(Plane), Furthest) + Plane.w < 0.0f)
+                {
+                    return EFrustumTest::Outside;
+                }
+                if (glm::dot(glm::vec3(Plane), Nearest) + Plane.w < 0.0f)
+                {
+                    Result = EFrustumTest::Intersecting;
+                }
+            }
+            return Result;
+        }
+
+        //left, right, bottom, top, near and far, as (normal, distance)
+        glm::vec4 Planes[6];
+
+        //w row of the matrix, giving depth, and how many clip units tall one world unit is at a depth of one
+        glm::vec4 DepthRow;
+        float VerticalScale;
+    };
+}
@@ -0,0 +1,49 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+typedef unsigned int GLuint;
+
+namespace Rendering
+{
+    /* GPUTimer
+     * Times GL commands on the GPU with GL_TIME_ELAPSED queries, reported to the Profiler as a GPU stage. Queries
+     * alternate between NumQueries objects, and a result is only read once the GPU says it's available, so timing
+     * never waits on the GPU. Results arrive a frame or more late, and a frame whose query object is still in flight
+     * isn't timed. Only one timer may be running at once, as GL doesn't nest elapsed time queries
+     */
+    class GPUTimer
+    {
+    public:
+        static constexpr int NumQueries = 2;
+
+        /** GPUTimer::Initialize
+         * Creates the queries. Requires a current GL context
+         * @param Name - name of the stage, which must outlive the profiler, i.e. a string literal
+         */
+        void Initialize(const char* Name);
+
+        //deletes the queries, call while the GL context is still current
+        void Release();
+
+        //starts timing the commands that follow, after reporting the results of earlier frames that have arrived
+        void Begin();
+
+        //stops timing
+        void End();
+
+    private:
+        //reports the result of a query in flight if it has arrived, returning whether the query is free again
+        bool Collect(int Query);
+
+        GLuint Queries[NumQueries] = {0};
+        //profiler time the query was started at, to place its result in traces
+        double StartTimes[NumQueries] = {0.0};
+        bool bInFlight[NumQueries] = {false};
+        int NextQuery = 0;
+        int ActiveQuery = -1;
+        int Stage = -1;
+    };
+}
@@ -3,8 +3,11 @@
 //
 
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include "glm.hpp"
+#include "rendering/StreamingBuffer.h"
 
 class Camera;
 typedef unsigned int GLenum;
@@ -14,13 +17,28 @@ namespace Rendering
 {
     class ShaderProgram;
 
+    /* GlobalUniforms
+     * Per frame state read by every shader program through the GlobalUniforms block, in its std140 layout.
+     * A vec3 is aligned to 16 bytes, so each one is followed by padding or by a float sharing its last 4 bytes
+     */
     struct GlobalUniforms
     {
-        glm::mat4 ViewMatrix;
-        glm::mat4 ProjectionMatrix;
-        glm::mat4 ViewProjectionMatrix;
+        glm::mat4 ViewMatrix = glm::mat4(1.0f);
+        glm::mat4 ProjectionMatrix = glm::mat4(1.0f);
+        glm::mat4 ViewProjectionMatrix = glm::mat4(1.0f);
+        glm::vec3 LightPosition = glm::vec3(0.0f);
+        float Padding0 = 0.0f;
+        glm::vec3 LightColor = glm::vec3(0.0f);
+        float Padding1 = 0.0f;
+        glm::vec3 AmbientColor = glm::vec3(0.0f);
+        float AmbientStrength = 0.0f;
     };
+    static_assert(sizeof(GlobalUniforms) == 240, "GlobalUniforms must match the std140 layout of the shader block");
 
+    /* VertexLayout
+     * A model vertex as stored on the GPU, with its attributes interleaved so fetching a vertex reads one
+     * contiguous 36 bytes rather than one location from each of three buffers
+     */
     struct VertexLayout
     {
         glm::vec3 Location;
@@ -33,22 +51,49 @@ namespace Rendering
     public:
         RenderingContext()=default;
 
+        //creates the model's vertex array and the global uniform buffer, requires a current GL context
         void Initialize();
 
+        //deletes the model's GPU objects and the uniform buffer, call while the GL context is still current
+        void Release();
+
+        /** RenderingContext::UpdateGlobalUniforms
+         * Uploads the per frame state shared by every program, skipping the upload when nothing has changed
+         * @param Uniforms - view, projection and lighting state for this frame
+         */
+        void UpdateGlobalUniforms(const GlobalUniforms& Uniforms);
+
+        /** RenderingContext::BeginModelUpload
+         * Maps space for the model's vertices, written in place until EndModelUpload
+         * @param NumVertices - number of vertices that will be written
+         * @return the vertices to fill in, or nullptr if the buffer couldn't be mapped
+         */
+        VertexLayout* BeginModelUpload(size_t NumVertices);
+
+        /** RenderingContext::EndModelUpload
+         * Finishes the upload, pointing the model's attributes at the vertices just written
+         * @return false if the vertices were lost, in which case nothing should be drawn
+         */
+        bool EndModelUpload();
+
+        //binds the model's vertex array, location 0 holds positions, 1 colors and 2 normals
+        void BindModel() const;
+
         static void SetActiveCamera(Camera* Camera);
 
         static void Update();
     private:
         Camera* ActiveCamera = nullptr;
         std::shared_ptr<ShaderProgram> ActiveShaderProgram;
-        GLuint ActiveVAO = 1 >> 31;
-        GLuint LocationVBO = 1 >> 31;
-        GLuint ColorVBO = 1 >> 31;
-        GLuint IndexBufferObject = 1 >> 31;
-        GLuint UBO_Block = 1 >> 31;
+        GLuint ActiveVAO = 0;
+        StreamingBuffer ModelVertices;
+        GLuint UBO_Block = 0;
+
+        //contents of UBO_Block as last uploaded
+        GlobalUniforms UploadedUniforms;
+        bool bUniformsUploaded = false;
 
         uint32_t NumVertices = 0;
-        uint32_t MaxVertices = 10000000;
     };
 
 }
@@ -5,6 +5,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace Rendering {
@@ -20,6 +21,17 @@ namespace Rendering {
 
   GLuint GetProgramID() const;
 
+  /** GetUniformLocation
+   * Looks up a uniform in the locations cached when the program was last linked, without querying GL
+   * @param UniformName - name of the uniform as declared in the shader
+   * @return location of the uniform, or -1 if the program has no such active uniform
+   */
+  int GetUniformLocation(const std::string& UniformName) const;
+
+  //name of the uniform block holding per frame state, and the binding point every program reads it from
+  static constexpr const char* GlobalUniformsBlockName = "GlobalUniforms";
+  static constexpr GLuint GlobalUniformsBinding = 0;
+
   /** AttachShaderObject
    * @param Object - the shader object to attach to the shader program
    */
@@ -41,6 +53,9 @@ namespace Rendering {
   void ReloadShaderObjects();
 
  protected:
+  //binds the global uniform block and caches the locations of the remaining active uniforms, after a link
+  void CacheUniforms();
+
   //name of the shader program
   std::string ProgramName;
 
@@ -49,5 +64,8 @@ namespace Rendering {
 
   //attached shader objects
   std::vector<std::shared_ptr<ShaderObject>> AttachedShaderObjects;
+
+  //locations of active uniforms outside of blocks, by name
+  std::unordered_map<std::string, int> UniformLocations;
  };
 }
@@ -0,0 +1,78 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+
+typedef unsigned int GLuint;
+typedef struct __GLsync* GLsync;
+
+namespace Rendering
+{
+    /* StreamingBuffer
+     * A vertex buffer written by the CPU through a mapping, rather than by copying a staging array with glBufferData
+     * When ARB_buffer_storage is available the buffer is mapped once, persistently and coherently, and split into
+     * two regions used in turn. A fence placed when a region stops being drawn is waited on before it is written
+     * again, so writing never stalls on draws of the data currently shown. Without it, each write orphans the
+     * buffer and maps it unsynchronized, which lets the driver hand out fresh storage instead of waiting
+     */
+    class StreamingBuffer
+    {
+    public:
+        StreamingBuffer() = default;
+        ~StreamingBuffer();
+
+        StreamingBuffer(const StreamingBuffer&) = delete;
+        StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+        /** BeginWrite
+         * Maps space for Size bytes, growing the buffer if it's too small. Requires a current GL context
+         * @param Size - number of bytes that will be written
+         * @return memory to write to until EndWrite, or nullptr if the buffer couldn't be mapped
+         */
+        void* BeginWrite(size_t Size);
+
+        /** EndWrite
+         * Finishes the write started by BeginWrite. The buffer, at GetDrawOffset, holds the data from now on
+         * @return false if the data was lost while mapped, and should be written again
+         */
+        bool EndWrite();
+
+        //buffer object holding the data last written, which changes when the buffer grows
+        GLuint GetBuffer() const { return Buffer; }
+
+        //byte offset of the data last written within GetBuffer
+        size_t GetDrawOffset() const { return DrawOffset; }
+
+        //whether the persistent mapped path is being used
+        bool IsPersistent() const { return bPersistent; }
+
+        //deletes the buffer and its fences, call while the GL context is still current
+        void Release();
+
+        //regions are a 1 / HeadroomDivisor larger than what they're allocated for
+        static constexpr size_t HeadroomDivisor = 8;
+        static constexpr int NumRegions = 2;
+
+        //most bytes the buffer allocates per byte written, rounding aside, with both regions of the persistent path
+        static constexpr double MaxBytesPerByteWritten = NumRegions * (1.0 + 1.0 / HeadroomDivisor);
+
+    private:
+        //recreates the buffer with regions of at least Size bytes
+        bool Allocate(size_t Size);
+
+        GLuint Buffer = 0;
+        bool bPersistent = false;
+
+        //persistent path, the whole buffer mapped once and the region being written
+        unsigned char* PersistentMapping = nullptr;
+        size_t RegionSize = 0;
+        int WriteRegion = 0;
+        GLsync RegionFences[NumRegions] = {nullptr};
+
+        size_t DrawOffset = 0;
+        bool bWriting = false;
+    };
+}
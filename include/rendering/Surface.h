@@ -0,0 +1,44 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+/* SurfaceInstance
+ * One placement of a predefined surface, recorded by the turtle for ~X
+ * Surface meshes are modelled in the turtle's frame: x to its right, y along its heading, z up
+ */
+struct SurfaceInstance
+{
+    glm::vec3 Location;
+    float Scale;
+    glm::vec3 Right;
+    glm::vec3 Up;
+    glm::vec3 Forward;
+    glm::vec3 Color;
+};
+
+/* SurfaceMesh
+ * Unindexed triangle soup of a predefined surface, three positions and normals per triangle
+ */
+struct SurfaceMesh
+{
+    /** LoadFromOBJ
+     * Loads the v, vn and f statements of a Wavefront OBJ file, fan triangulating faces with more than three
+     * vertices. Faces without normals are given their face normal
+     * @param Filename - the file to load
+     * @return true if the file was read and held at least one triangle
+     */
+    bool LoadFromOBJ(const char* Filename);
+
+    /** BuiltInLeaf
+     * @return a flat leaf, used for surfaces without a mesh of their own
+     */
+    static SurfaceMesh BuiltInLeaf();
+
+    std::vector<glm::vec3> Positions;
+    std::vector<glm::vec3> Normals;
+};
@@ -0,0 +1,73 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "rendering/Surface.h"
+
+typedef unsigned int GLuint;
+
+namespace Rendering
+{
+    /* SurfaceLibrary
+     * Predefined surfaces incorporated by ~X, each uploaded to the GPU once and drawn with a single instanced draw
+     * covering every placement the turtle recorded for it
+     */
+    class SurfaceLibrary
+    {
+    public:
+        static constexpr int MaxSurfaces = 128;
+
+        static SurfaceLibrary* Get();
+
+        /** LoadFromDirectory
+         * Reads the "surfaces" index in Directory, where each line NAME:FILE maps a symbol to an OBJ file,
+         * i.e. L:leaf.obj. Requires a current GL context
+         * @param Directory - directory holding the index and meshes
+         */
+        void LoadFromDirectory(const std::string& Directory);
+
+        /** UploadInstances
+         * Replaces the instances drawn for every surface. Names without a mesh of their own use the built in leaf
+         * @param Instances - instances by surface name, MaxSurfaces entries
+         * @param Offset - offset applied to every instance location
+         */
+        void UploadInstances(const std::vector<SurfaceInstance>* Instances, const glm::vec3& Offset);
+
+        //draws every surface with instances, with the instanced surface shader already in use
+        void Draw() const;
+
+        //total number of instances uploaded
+        size_t GetNumInstances() const { return NumInstances; }
+
+    private:
+        SurfaceLibrary() = default;
+
+        struct GPUSurface
+        {
+            GLuint VAO = 0;
+            GLuint MeshVBO = 0;
+            GLuint InstanceVBO = 0;
+            int NumVertices = 0;
+            int NumInstances = 0;
+        };
+
+        //creates the buffers of a surface, returning false if it already has a mesh
+        bool CreateSurface(char Name, const SurfaceMesh& Mesh);
+
+        //index of the surface drawn for names without a mesh
+        static constexpr int DefaultSurface = 0;
+
+        GPUSurface Surfaces[MaxSurfaces];
+        size_t NumInstances = 0;
+
+        //staging for UploadInstances, kept around so their storage is reused between uploads
+        std::vector<SurfaceInstance> DefaultInstances;
+        std::vector<SurfaceInstance> ShiftedInstances;
+
+        static SurfaceLibrary* sSurfaceLibrary;
+    };
+}
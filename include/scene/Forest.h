@@ -0,0 +1,110 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "scene/GenerationCache.h"
+
+typedef unsigned int GLuint;
+
+namespace Scene
+{
+    /* PlantInstance
+     * One plant of the forest. The GPU reads the first two vec4s, the seed its variation was drawn from is kept
+     * alongside so a plant can be told apart from its neighbours
+     */
+    struct PlantInstance
+    {
+        glm::vec3 Location;
+        float Scale;
+        glm::vec3 Tint;
+        float Yaw;
+        uint32_t Seed;
+    };
+
+    /* Forest
+     * Many plants scattered over the ground, drawn from a few species. Each species is a generated model uploaded
+     * once, and all of its plants are drawn with one instanced draw, so a forest costs a draw per species rather
+     * than a regeneration per plant. Plants vary by location, yaw, scale and tint, drawn from their own seed.
+     * Species hold their generated model, so it stays in the GenerationCache while the forest uses it. The predefined
+     * surfaces a species places are composed with every plant's placement when scattering, for the SurfaceLibrary
+     * to draw
+     */
+    class Forest
+    {
+    public:
+        static constexpr int MaxSpecies = 8;
+
+        /** Forest::AddSpecies
+         * Uploads a generated model as a new species, with its base at the origin. A model already planted only has
+         * its weight raised. Requires a current GL context
+         * @param Model - the generated model
+         * @param Weight - share of the plants given to the species, relative to the other species
+         * @return index of the species, or -1 if there is no room for another
+         */
+        int AddSpecies(const std::shared_ptr<const GeneratedModel>& Model, float Weight = 1.0f);
+
+        /** Forest::LoadFromFile
+         * Adds the species of a scene file, where each line SYSTEM COUNT names a system file, relative to the scene,
+         * and how many plants of it to place. Systems are generated through the GenerationCache, so a system named
+         * by many lines, or by other scenes, is generated once
+         * @param Filename - the scene file
+         * @return total number of plants the scene asks for, or -1 if it couldn't be read
+         */
+        int LoadFromFile(const char* Filename);
+
+        /** Forest::Scatter
+         * Replaces every plant, spreading NumPlants over a disc around the origin. Each species gets a share of the
+         * plants proportional to its weight
+         * @param NumPlants - number of plants
+         * @param Radius - radius of the disc
+         * @param Seed - seed every plant's own seed is drawn from
+         */
+        void Scatter(int NumPlants, float Radius, uint32_t Seed);
+
+        /** Forest::Draw
+         * Draws every species with plants, one instanced draw each, with the forest shader already in use
+         * @param bTwoSided - whether to draw the species' two sided triangles rather than the one sided ones
+         */
+        void Draw(bool bTwoSided) const;
+
+        //removes every species and plant
+        void Clear();
+
+        //deletes the GPU objects, call while the GL context is still current
+        void Release();
+
+        int GetNumSpecies() const { return NumSpecies; }
+        size_t GetNumPlants() const { return NumPlants; }
+
+        //predefined surfaces placed by every plant, in world space, by surface name
+        const std::vector<SurfaceInstance>* GetSurfaceInstances() const { return SurfaceInstances; }
+
+    private:
+        struct Species
+        {
+            GLuint VAO = 0;
+            GLuint MeshVBO = 0;
+            GLuint InstanceVBO = 0;
+            std::shared_ptr<const GeneratedModel> Model;
+            float Weight = 0.0f;
+            int NumOneSidedVertices = 0;
+            int NumTwoSidedVertices = 0;
+            int NumPlants = 0;
+        };
+
+        Species AllSpecies[MaxSpecies];
+        int NumSpecies = 0;
+        size_t NumPlants = 0;
+
+        //plants of one species at a time while scattering, kept around so their storage is reused
+        std::vector<PlantInstance> SpeciesPlants[MaxSpecies];
+
+        std::vector<SurfaceInstance> SurfaceInstances[128];
+    };
+}
@@ -0,0 +1,103 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "rendering/ColoredTriangle.h"
+#include "rendering/ConeSegment.h"
+#include "rendering/Surface.h"
+
+class LSystem;
+class Turtle;
+
+namespace Scene
+{
+    /* GeneratedModel
+     * Everything the turtle drew for a system, sized to fit, and shared read only by everything using the system
+     */
+    struct GeneratedModel
+    {
+        explicit GeneratedModel(long long NumTriangles) : Triangles(static_cast<int>(NumTriangles)) {}
+
+        GeneratedModel(const GeneratedModel&) = delete;
+        GeneratedModel& operator=(const GeneratedModel&) = delete;
+
+        //content hash of the system it was generated from
+        uint64_t Hash = 0;
+
+        ColoredTriangleList Triangles;
+        std::vector<ConeSegment> Segments;
+        std::vector<SurfaceInstance> SurfaceInstances[128];
+
+        //bytes held by the model, counted against the cache's budget
+        size_t Bytes = 0;
+    };
+
+    /* GenerationCache
+     * Generated models by the content hash of their system, so every object drawing the same system shares a
+     * single generation. Models are handed out reference counted; once the cache outgrows its memory budget, the
+     * least recently used models nothing else holds are dropped
+     */
+    class GenerationCache
+    {
+    public:
+        static constexpr size_t DefaultMemoryBudget = size_t(512) << 20;
+
+        static GenerationCache* Get();
+
+        /** GenerationCache::Acquire
+         * Returns the model of System, generating it if it isn't cached. Generating rewrites System in place
+         * @param System - the system to draw
+         * @return the model, or nullptr if the system generated nothing
+         */
+        std::shared_ptr<const GeneratedModel> Acquire(LSystem& System);
+
+        /** GenerationCache::SetMemoryBudget
+         * Sets the bytes the cache may hold, dropping models until it's under it
+         * @param Bytes - the new budget
+         */
+        void SetMemoryBudget(size_t Bytes);
+
+        //drops every model nothing else holds
+        void Clear();
+
+        size_t GetMemoryUsed() const { return MemoryUsed; }
+        size_t GetNumModels() const { return Entries.size(); }
+        uint64_t GetNumHits() const { return NumHits; }
+        uint64_t GetNumMisses() const { return NumMisses; }
+
+    private:
+        GenerationCache();
+        ~GenerationCache();
+
+        struct Entry
+        {
+            std::shared_ptr<GeneratedModel> Model;
+            //position in RecentlyUsed
+            std::list<uint64_t>::iterator Use;
+        };
+
+        //drops the least recently used models nothing else holds until MemoryUsed is within Budget
+        void Trim(size_t Budget);
+
+        std::unordered_map<uint64_t, Entry> Entries;
+        //hashes of cached models, most recently acquired first
+        std::list<uint64_t> RecentlyUsed;
+        size_t MemoryBudget = DefaultMemoryBudget;
+        size_t MemoryUsed = 0;
+        uint64_t NumHits = 0;
+        uint64_t NumMisses = 0;
+
+        //turtle and full sized triangle list models are drawn into before being copied out to fit
+        Turtle* Generator = nullptr;
+        ColoredTriangleList* Scratch = nullptr;
+
+        static GenerationCache* sGenerationCache;
+    };
+}
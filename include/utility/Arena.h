@@ -0,0 +1,74 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* Arena
+ * Bump allocator handing out memory from a chain of blocks, each at least twice the size of the last
+ * Individual allocations are never freed, everything is released at once by Reset or when the arena is destroyed
+ * Allocation is a pointer bump in the common case, and a single malloc when a block runs out
+ */
+class Arena
+{
+public:
+    /** Arena
+     * @param InitialBlockSize - size of the first block, allocated on first use
+     */
+    explicit Arena(size_t InitialBlockSize = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /** Allocate
+     * @param Size - number of bytes
+     * @param Alignment - required alignment, a power of two
+     * @return uninitialized memory, or nullptr if the system is out of memory
+     */
+    void* Allocate(size_t Size, size_t Alignment = alignof(std::max_align_t));
+
+    //uninitialized storage for Count elements of type T
+    template<typename T>
+    T* AllocateArray(const size_t Count)
+    {
+        return static_cast<T*>(Allocate(Count * sizeof(T), alignof(T)));
+    }
+
+    /** Reset
+     * Releases every allocation, keeping only the largest block so the next round of allocations doesn't hit malloc
+     */
+    void Reset();
+
+    //bytes handed out since the last reset
+    size_t GetBytesUsed() const { return BytesUsed; }
+
+    //bytes held in blocks
+    size_t GetBytesReserved() const { return BytesReserved; }
+
+    /** GetThreadArena
+     * Arena owned by the calling thread, for long-lived per-thread structures such as the turtle's branch stack
+     * It is never reset, as anything could be holding memory from it
+     */
+    static Arena& GetThreadArena();
+
+private:
+    struct Block
+    {
+        Block* Previous;
+        size_t Size;
+        size_t Used;
+    };
+
+    //adds a block able to hold at least Size bytes at Alignment
+    bool AddBlock(size_t Size, size_t Alignment);
+
+    //the block currently being allocated from, older blocks are reached through Previous
+    Block* CurrentBlock = nullptr;
+    size_t NextBlockSize;
+    size_t BytesUsed = 0;
+    size_t BytesReserved = 0;
+};
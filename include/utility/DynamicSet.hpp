@@ -1,108 +1,182 @@
 #pragma once
 
-#include <stdio.h>
-#include <stdlib.h>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 /***
-* @file dyset.h
+* @file DynamicSet.hpp
 *     a simple templated dynamic set of elements which allows adding and removing elements, to be used when
 *     the order of elements does not matter, opting for adding and remove speed over order consistency
+*
+*     storage grows geometrically, so adding n elements costs O(n) in total. The first InlineCapacity elements live
+*     inside the set itself and need no allocation at all. With bStableAddresses the elements are kept in chunks
+*     which are never moved once allocated, so pointers to elements stay valid as the set grows (only removal
+*     moves an element, the last one, into the removed slot). Failures are reported through return values rather
+*     than by exiting, and elements are constructed and destroyed properly, so move-only and non-trivial types work
 */
 
-#define DYSET_ALLOCATION_FAILURE 0xDEADBEEF
-#define DYSET_INVALID_INDEX 0xBAADF00D
-
-template <typename ElementType>
+template <typename ElementType, size_t InlineCapacity = 0, bool bStableAddresses = false>
 class DynamicSet
 {
+    static_assert(alignof(ElementType) <= alignof(std::max_align_t), "DynamicSet: over-aligned element types are not supported");
+    static_assert(!(bStableAddresses && InlineCapacity > 0), "DynamicSet: inline storage would move with the set, so it can't be combined with stable addresses");
+
+    //types that can be moved with memcpy and need no destruction, relocated with realloc when growing
+    static constexpr bool bTriviallyRelocatable = std::is_trivially_copyable<ElementType>::value && std::is_trivially_destructible<ElementType>::value;
+
 public:
 
     /***
-    * @brief Default constructor, initialize variables and allocate initial storage for elements
+    * @brief Default constructor, no storage is allocated until the inline storage (if any) is full
     */
-    DynamicSet() : MaxElements(0), NumElements(0), NumAllocations(1), Data(nullptr)
-    {
-        Data = (ElementType*) malloc(ExpansionSize * NumAllocations * sizeof(ElementType));
-
-        if (Data == nullptr)
-        {
-            //this should realistically never happen, so exiting the application is appropriate
-            fprintf(stderr, "%s:%d: DynamicSet::DynamicSet: error constructing dyset, initial allocation failed. exiting.\n", __FILE__, __LINE__);
-            exit(DYSET_ALLOCATION_FAILURE);
-        }
-        MaxElements = ExpansionSize;
-    };
+    DynamicSet() = default;
 
     /***
-    * @brief Destruct object, free used data if necessary
+    * @brief Destruct object, destroying the elements and freeing used data if necessary
     */
     ~DynamicSet()
     {
-        if (Data != nullptr)
+        Empty();
+        Release();
+    }
+
+    DynamicSet(const DynamicSet&) = delete;
+    DynamicSet& operator=(const DynamicSet&) = delete;
+
+    DynamicSet(DynamicSet&& Other) noexcept
+    {
+        TakeFrom(Other);
+    }
+
+    DynamicSet& operator=(DynamicSet&& Other) noexcept
+    {
+        if (this != &Other)
         {
-            free(Data);
-            Data = nullptr;
+            Empty();
+            Release();
+            TakeFrom(Other);
         }
+        return *this;
     }
 
     /***
-    * @brief Remove the element at the specified index
-    * @param i The index of the element to remove.
-    * @return The element at the given index (if valid).
-    *
-    * @warning This function exits the program if the index is out of bounds, preferring crashing early and
-    *          loudly over breaking silently with potential side-effects
+    * @brief Remove the element at the specified index, moving the last element into its place
+    * @param Index The index of the element to remove
+    * @param OutElement If not null, receives the removed element
+    * @return False if the index is out of bounds, in which case the set is unchanged
     */
-    ElementType RemoveIndex(int i)
+    bool RemoveIndex(int Index, ElementType* OutElement = nullptr)
     {
-        if (i >= 0 && i < NumElements)
+        if (Index < 0 || Index >= NumElements)
         {
-            ElementType Returned = Data[i];
-            Data[i] = Data[NumElements - 1];
-            NumElements -= 1;
-            return Returned;
+            return false;
         }
-        else
+
+        ElementType& Removed = At(Index);
+        if (OutElement != nullptr)
         {
-            fprintf(stderr, "%s:%d: DynamicSet::RemoveIndex: error removing index %d, invalid index. exiting\n", __FILE__, __LINE__, i);
-            exit(DYSET_INVALID_INDEX);
+            *OutElement = std::move(Removed);
         }
+
+        ElementType& Last = At(NumElements - 1);
+        if (&Removed != &Last)
+        {
+            Removed = std::move(Last);
+        }
+        Last.~ElementType();
+        NumElements--;
+        return true;
     }
 
     /***
-    * @brief Remove the last index in the set
-    * @return The last element in the set (if valid)
-    *
-    * @warning This function exits the program if the index is out of bounds, preferring crashing early and
-    *          loudly over breaking silently with potential side-effects
+    * @brief Remove the last element in the set
+    * @param OutElement If not null, receives the removed element
+    * @return False if the set is empty
     */
-    ElementType RemoveLast()
+    bool RemoveLast(ElementType* OutElement = nullptr)
     {
-        return RemoveIndex(NumElements - 1);
+        return RemoveIndex(NumElements - 1, OutElement);
     }
 
     /***
     * @brief Add the given element to the set, expanding if necessary
     * @param Element - The element to add to the set
+    * @return False if storage couldn't be allocated, in which case the set is unchanged
+    */
+    bool Add(const ElementType& Element)
+    {
+        return Emplace(Element);
+    }
+
+    bool Add(ElementType&& Element)
+    {
+        return Emplace(std::move(Element));
+    }
+
+    /***
+    * @brief Construct an element in place at the end of the set, expanding if necessary
+    * @param Args - Arguments forwarded to the element's constructor
+    * @return False if storage couldn't be allocated, in which case the set is unchanged
     */
-    void Add(const ElementType& Element)
+    template <typename... ArgTypes>
+    bool Emplace(ArgTypes&&... Args)
     {
-        if (NumElements == MaxElements)
+        if constexpr (!bStableAddresses)
         {
-            Expand();
+            //the arguments may refer to elements of the set, which growing moves, so the new element is built
+            //before they're relocated
+            if (NumElements == MaxElements)
+            {
+                ElementType Element(std::forward<ArgTypes>(Args)...);
+                if (!Expand(MaxElements + 1))
+                {
+                    return false;
+                }
+                new (Slot(NumElements)) ElementType(std::move(Element));
+                NumElements++;
+                return true;
+            }
         }
 
-        Data[NumElements] = Element;
+        if (NumElements == MaxElements && !Expand(MaxElements + 1))
+        {
+            return false;
+        }
 
+        new (Slot(NumElements)) ElementType(std::forward<ArgTypes>(Args)...);
         NumElements++;
+        return true;
     }
 
     /***
-     * @brief Clears the elements for use
-     * @note Does not free the associated memory
+    * @brief Make room for at least the given number of elements without further allocation
+    * @return False if storage couldn't be allocated
+    */
+    bool Reserve(int Capacity)
+    {
+        return Capacity <= MaxElements || Expand(Capacity);
+    }
+
+    /***
+     * @brief Clears the elements for use, destroying them
+     * @note Does not free the associated memory, so refilling the set doesn't allocate again
     */
     void Empty()
     {
+        if (!std::is_trivially_destructible<ElementType>::value)
+        {
+            for (int i = 0; i < NumElements; i++)
+            {
+                At(i).~ElementType();
+            }
+        }
         NumElements = 0;
     }
 
@@ -124,53 +198,255 @@ public:
         return NumElements;
     }
 
+    /***
+    * @brief Return the number of elements the set can hold before it next allocates
+    */
+    int Capacity() const
+    {
+        return MaxElements;
+    }
+
     /***
     * @brief Bracket overload, return element at the given index
-    * @param Index The index of the element to return
+    * @param Index The index of the element to return, which must be in bounds (checked by assert)
     * @return The element at the given index
-    *
-    * @warning This function exits the program if the index is out of bounds, preferring crashing early and
-    *          loudly over breaking silently with potential side-effects
     */
-    ElementType& operator[](int Index) const
+    ElementType& operator[](int Index)
     {
-        if(Index >= 0 && Index < NumElements)
-        {
-            return Data[Index];
-        }
+        assert(Index >= 0 && Index < NumElements);
+        return At(Index);
+    }
+
+    const ElementType& operator[](int Index) const
+    {
+        assert(Index >= 0 && Index < NumElements);
+        return const_cast<DynamicSet*>(this)->At(Index);
+    }
+
+    /***
+    * @brief Return the element at the given index, or null if the index is out of bounds
+    */
+    ElementType* Find(int Index)
+    {
+        return Index >= 0 && Index < NumElements ? &At(Index) : nullptr;
+    }
 
-        //report invaid access and crash
-        fprintf(stderr, "%s:%d: DynamicSet::operator[]: error accessing index %d, invalid index. exiting\n", __FILE__, __LINE__);
-        exit(DYSET_INVALID_INDEX);
+    /***
+    * @brief Return the contiguous array of elements, only available without stable addresses
+    */
+    ElementType* GetData()
+    {
+        static_assert(!bStableAddresses, "DynamicSet: chunked storage is not contiguous");
+        return Data;
     }
 
 private:
-    int MaxElements = 0;
+    //chunk c holds FirstChunkSize << c elements, so an index maps to its chunk with one bit scan, and the chunks
+    //together hold just under INT32_MAX elements
+    static constexpr int FirstChunkShift = 6;
+    static constexpr size_t FirstChunkSize = size_t(1) << FirstChunkShift;
+    static constexpr int MaxChunks = 31 - FirstChunkShift;
+
+    //storage for the first InlineCapacity elements, sized to at least one element so the array is never empty
+    alignas(ElementType) unsigned char InlineStorage[sizeof(ElementType) * (InlineCapacity > 0 ? InlineCapacity : 1)];
+
+    int MaxElements = static_cast<int>(InlineCapacity);
     int NumElements = 0;
-    int NumAllocations = 0;
-    const int ExpansionSize = 1024;
-    ElementType* Data = nullptr;
+    ElementType* Data = InlineCapacity > 0 ? reinterpret_cast<ElementType*>(InlineStorage) : nullptr;
+    ElementType* Chunks[bStableAddresses ? MaxChunks : 1] = {};
+    int NumChunks = 0;
+
+    static int HighestBit(const uint32_t Value)
+    {
+        int Bit = 0;
+#if defined(__GNUC__) || defined(__clang__)
+        Bit = 31 - __builtin_clz(Value);
+#else
+        for (uint32_t Remaining = Value >> 1; Remaining != 0; Remaining >>= 1)
+        {
+            Bit++;
+        }
+#endif
+        return Bit;
+    }
+
+    //address of the slot for the given index, which must be below MaxElements
+    void* Slot(int Index)
+    {
+        if constexpr (bStableAddresses)
+        {
+            const uint32_t Biased = static_cast<uint32_t>(Index) + static_cast<uint32_t>(FirstChunkSize);
+            const int Chunk = HighestBit(Biased) - FirstChunkShift;
+            return Chunks[Chunk] + (Biased - (static_cast<uint32_t>(FirstChunkSize) << Chunk));
+        }
+        else
+        {
+            return Data + Index;
+        }
+    }
+
+    ElementType& At(int Index)
+    {
+        return *static_cast<ElementType*>(Slot(Index));
+    }
+
+    bool IsInline() const
+    {
+        return InlineCapacity > 0 && Data == reinterpret_cast<const ElementType*>(InlineStorage);
+    }
 
     /***
-    * @brief Expand the dynamic set, allowing for more elements to be stored
-    *
-    * @warning This function exits the program if reallocation fails, preferring crashing early and
-    *          loudly over breaking silently with potential side-effects
+    * @brief Expand the dynamic set, allowing for at least MinElements to be stored
+    * @return False if allocation failed, in which case nothing is changed
     */
-    void Expand()
+    bool Expand(int MinElements)
+    {
+        if constexpr (bStableAddresses)
+        {
+            //add chunks until the requested count fits, existing chunks are left where they are
+            while (MaxElements < MinElements)
+            {
+                if (NumChunks == MaxChunks)
+                {
+                    return false;
+                }
+
+                const size_t ChunkSize = FirstChunkSize << NumChunks;
+                auto* NewChunk = static_cast<ElementType*>(malloc(ChunkSize * sizeof(ElementType)));
+                if (NewChunk == nullptr)
+                {
+                    fprintf(stderr, "%s:%d: DynamicSet::Expand: error allocating a chunk of %zu elements\n", __FILE__, __LINE__, ChunkSize);
+                    return false;
+                }
+                Chunks[NumChunks++] = NewChunk;
+                MaxElements += static_cast<int>(ChunkSize);
+            }
+            return true;
+        }
+        else
+        {
+            //double the capacity, so the cost of copying on growth is amortized over the elements added
+            size_t NewMax = MaxElements > 0 ? static_cast<size_t>(MaxElements) : 8;
+            while (NewMax < static_cast<size_t>(MinElements))
+            {
+                NewMax *= 2;
+            }
+            if (NewMax > static_cast<size_t>(INT32_MAX))
+            {
+                return false;
+            }
+
+            ElementType* NewData = nullptr;
+            if constexpr (bTriviallyRelocatable)
+            {
+                //realloc can often grow in place, and otherwise moves the bytes for us
+                if (!IsInline())
+                {
+                    NewData = static_cast<ElementType*>(realloc(static_cast<void*>(Data), NewMax * sizeof(ElementType)));
+                }
+            }
+            if (NewData == nullptr && (!bTriviallyRelocatable || IsInline()))
+            {
+                NewData = static_cast<ElementType*>(malloc(NewMax * sizeof(ElementType)));
+                if (NewData != nullptr)
+                {
+                    Relocate(Data, NewData, NumElements);
+                    if (!IsInline())
+                    {
+                        free(Data);
+                    }
+                }
+            }
+
+            if (NewData == nullptr)
+            {
+                fprintf(stderr, "%s:%d: DynamicSet::Expand: error allocating %zu elements\n", __FILE__, __LINE__, NewMax);
+                return false;
+            }
+
+            Data = NewData;
+            MaxElements = static_cast<int>(NewMax);
+            return true;
+        }
+    }
+
+    //moves Count elements into uninitialized storage, leaving the source destroyed
+    static void Relocate(ElementType* Source, ElementType* Destination, int Count)
+    {
+        if constexpr (bTriviallyRelocatable)
+        {
+            if (Count > 0)
+            {
+                memcpy(static_cast<void*>(Destination), static_cast<const void*>(Source), Count * sizeof(ElementType));
+            }
+        }
+        else
+        {
+            for (int i = 0; i < Count; i++)
+            {
+                new (Destination + i) ElementType(std::move(Source[i]));
+                Source[i].~ElementType();
+            }
+        }
+    }
+
+    //frees heap storage, the elements must already be destroyed
+    void Release()
+    {
+        if constexpr (bStableAddresses)
+        {
+            for (int i = 0; i < NumChunks; i++)
+            {
+                free(Chunks[i]);
+                Chunks[i] = nullptr;
+            }
+            NumChunks = 0;
+            MaxElements = 0;
+        }
+        else
+        {
+            if (!IsInline())
+            {
+                free(Data);
+            }
+            Data = InlineCapacity > 0 ? reinterpret_cast<ElementType*>(InlineStorage) : nullptr;
+            MaxElements = static_cast<int>(InlineCapacity);
+        }
+    }
+
+    //takes Other's elements, leaving it empty, this set must be empty and released
+    void TakeFrom(DynamicSet& Other)
     {
-        NumAllocations++;
-        ElementType* reallocdat = (ElementType*) realloc(Data, ExpansionSize * NumAllocations * sizeof(ElementType));
-        if (reallocdat != nullptr)
+        if constexpr (bStableAddresses)
         {
-            Data = reallocdat;
-            MaxElements = NumAllocations * ExpansionSize;
+            for (int i = 0; i < Other.NumChunks; i++)
+            {
+                Chunks[i] = Other.Chunks[i];
+                Other.Chunks[i] = nullptr;
+            }
+            NumChunks = Other.NumChunks;
+            MaxElements = Other.MaxElements;
+            NumElements = Other.NumElements;
+            Other.NumChunks = 0;
+            Other.MaxElements = 0;
+            Other.NumElements = 0;
         }
         else
         {
-            //this should realistically never happen, so exiting the application is appropriate
-            fprintf(stderr, "%s:%d: DynamicSet::Expand: error re-allocating element array. exiting\n", __FILE__, __LINE__);
-            exit(DYSET_ALLOCATION_FAILURE);
+            if (Other.IsInline())
+            {
+                //inline elements have to be moved across individually
+                Relocate(Other.Data, Data, Other.NumElements);
+            }
+            else
+            {
+                Data = Other.Data;
+                MaxElements = Other.MaxElements;
+                Other.Data = InlineCapacity > 0 ? reinterpret_cast<ElementType*>(Other.InlineStorage) : nullptr;
+                Other.MaxElements = static_cast<int>(InlineCapacity);
+            }
+            NumElements = Other.NumElements;
+            Other.NumElements = 0;
         }
     }
 };
@@ -0,0 +1,54 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+* @file Hash.h
+* 64 bit FNV-1a hashing, used to key content by value. Every function continues from the hash it's given, so a
+* record is hashed by chaining a call per field
+*/
+
+constexpr uint64_t FnvOffsetBasis = 0xCBF29CE484222325ull;
+constexpr uint64_t FnvPrime = 0x100000001B3ull;
+
+/** HashBytes
+ * @param Data - bytes to hash
+ * @param Size - number of bytes
+ * @param Hash - hash to continue from
+ * @return the hash of the bytes
+ */
+inline uint64_t HashBytes(const void* Data, size_t Size, uint64_t Hash = FnvOffsetBasis)
+{
+    const auto* Bytes = static_cast<const unsigned char*>(Data);
+    for (size_t i = 0; i < Size; i++)
+    {
+        Hash ^= Bytes[i];
+        Hash *= FnvPrime;
+    }
+    return Hash;
+}
+
+//hashes a string along with its terminator, so consecutive strings can't run into one another
+inline uint64_t HashString(const char* String, uint64_t Hash = FnvOffsetBasis)
+{
+    return HashBytes(String, strlen(String) + 1, Hash);
+}
+
+//hashes an integer's bytes
+template<typename T>
+inline uint64_t HashValue(const T Value, uint64_t Hash = FnvOffsetBasis)
+{
+    return HashBytes(&Value, sizeof(T), Hash);
+}
+
+//hashes a float's bits, with -0 hashed as 0 since they compare equal
+inline uint64_t HashFloat(const float Value, uint64_t Hash = FnvOffsetBasis)
+{
+    const float Canonical = Value == 0.0f ? 0.0f : Value;
+    return HashBytes(&Canonical, sizeof(float), Hash);
+}
@@ -0,0 +1,138 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Profiler
+ * Times named stages of work. Each stage keeps its total for every one of the last HistoryLength frames, for graphing,
+ * and while a capture is running every sample is also kept as an event, written out as a Chrome trace
+ * (chrome://tracing or ui.perfetto.dev) to see where a slow system spends its time
+ */
+class Profiler
+{
+public:
+    static constexpr int MaxStages = 32;
+    static constexpr int HistoryLength = 240;
+    //events kept by a capture, later samples are dropped once it's full
+    static constexpr size_t MaxTraceEvents = 1 << 20;
+
+    static Profiler* Get();
+
+    /** Profiler::RegisterStage
+     * @param Name - name of the stage, which must outlive the profiler, i.e. a string literal
+     * @param bGPU - whether the stage is timed on the GPU, and drawn on its own track in traces
+     * @return index of the stage, the existing one if it's already registered, or -1 if there is no room
+     */
+    int RegisterStage(const char* Name, bool bGPU = false);
+
+    /** Profiler::AddSample
+     * Adds a timing of a stage to the current frame, and to the capture if one is running
+     * @param Stage - index of the stage
+     * @param Start - seconds since the profiler was created when the work started
+     * @param Duration - seconds the work took
+     */
+    void AddSample(int Stage, double Start, double Duration);
+
+    //seconds since the profiler was created
+    double Now() const;
+
+    //closes the current frame, moving every stage's total for it into the history
+    void EndFrame();
+
+    //starts keeping every sample as a trace event, dropping those of any earlier capture
+    void StartCapture();
+    void StopCapture();
+    bool IsCapturing() const { return bCapturing; }
+    size_t GetNumTraceEvents() const { return TraceEvents.size(); }
+
+    /** Profiler::WriteChromeTrace
+     * Writes the captured events in the Chrome trace event format
+     * @param Filename - file to write
+     * @return whether the file was written
+     */
+    bool WriteChromeTrace(const char* Filename) const;
+
+    int GetNumStages() const { return NumStages; }
+    const char* GetStageName(int Stage) const { return Stages[Stage].Name; }
+    bool IsGPUStage(int Stage) const { return Stages[Stage].bGPU; }
+
+    //milliseconds per frame of a stage, oldest first from GetHistoryOffset, wrapping around
+    const float* GetHistory(int Stage) const { return Stages[Stage].History; }
+    int GetHistoryOffset() const { return HistoryPosition; }
+
+    //milliseconds of a stage in the last completed frame
+    float GetLastFrameTime(int Stage) const;
+
+private:
+    Profiler();
+
+    struct Stage
+    {
+        const char* Name = nullptr;
+        bool bGPU = false;
+        //milliseconds of the frame in progress
+        double FrameTotal = 0.0;
+        float History[HistoryLength] = {0};
+    };
+
+    struct TraceEvent
+    {
+        int Stage;
+        uint32_t Thread;
+        double Start;
+        double Duration;
+    };
+
+    //small number for a thread, in the order threads first record a sample
+    uint32_t GetThreadNumber(std::thread::id Thread);
+
+    Stage Stages[MaxStages];
+    int NumStages = 0;
+    int HistoryPosition = 0;
+
+    bool bCapturing = false;
+    std::vector<TraceEvent> TraceEvents;
+    std::vector<std::thread::id> Threads;
+
+    std::chrono::steady_clock::time_point Epoch;
+    mutable std::mutex Lock;
+
+    static Profiler* sProfiler;
+};
+
+/* ScopedTimer
+ * Times its own lifetime as a sample of a stage
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const int Stage) : Stage(Stage), Start(Profiler::Get()->Now()) {}
+
+    ~ScopedTimer()
+    {
+        Profiler* Instance = Profiler::Get();
+        Instance->AddSample(Stage, Start, Instance->Now() - Start);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    int Stage;
+    double Start;
+};
+
+#define PROFILE_CONCATENATE_INNER(A, B) A##B
+#define PROFILE_CONCATENATE(A, B) PROFILE_CONCATENATE_INNER(A, B)
+
+//times the rest of the enclosing scope as the stage Name, registered the first time the scope runs
+#define PROFILE_SCOPE(Name) \
+    static const int PROFILE_CONCATENATE(ProfileStage, __LINE__) = Profiler::Get()->RegisterStage(Name); \
+    const ScopedTimer PROFILE_CONCATENATE(ProfileTimer, __LINE__)(PROFILE_CONCATENATE(ProfileStage, __LINE__))
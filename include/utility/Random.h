@@ -0,0 +1,35 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+
+/**
+* @file Random.h
+* counter-based random numbers. Instead of advancing a shared generator state, every random value is a pure function
+* of a (seed, stream, counter) triple, so values can be produced in any order, on any thread, and still match
+*/
+
+//SplitMix64 finalizer, a fast bijective 64 bit mixing function
+inline uint64_t MixBits64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+/** CounterRandom
+ * @param Seed - the user-facing seed
+ * @param Stream - independent stream, e.g. the rewriting generation
+ * @param Counter - position within the stream, e.g. the symbol index
+ * @return 64 uniformly distributed random bits
+ */
+inline uint64_t CounterRandom(uint64_t Seed, uint64_t Stream, uint64_t Counter)
+{
+    return MixBits64(MixBits64(Seed + 0x9E3779B97F4A7C15ull * (Stream + 1)) + 0xD1B54A32D192ED03ull * (Counter + 1));
+}
@@ -3,73 +3,208 @@
 //
 #pragma once
 
-#include <cstdio>
-
-#define STACK_ALLOCATION_FAILURE 0
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "Arena.h"
 
+/* Stack
+ * Typed LIFO stack whose storage is a chain of segments carved from an arena, each twice the size of the last
+ * Growing never copies existing elements, and segments are kept once allocated, so a stack that is reused every
+ * frame stops allocating after the first deep push. The thread's arena is never reset, so a stack taking its
+ * segments from there hands them to a per-thread free list when destroyed, which later stacks of the same type take
+ * from before the arena. Segments from a caller's arena live as long as that arena
+ */
 template<typename ElementType>
 class Stack
 {
 public:
-    Stack()
+    /** Stack
+     * @param InArena - arena to take segments from, the calling thread's arena if null
+     */
+    explicit Stack(Arena* InArena = nullptr)
+        : SourceArena(InArena)
     {
-        Elements = static_cast<ElementType*>(malloc(ExpansionSize * NumAllocations * sizeof(ElementType)));
+    }
 
-        if (Elements == nullptr)
+    ~Stack()
+    {
+        Clear();
+        Release();
+    }
+
+    Stack(const Stack&) = delete;
+    Stack& operator=(const Stack&) = delete;
+
+    /** Push
+     * @param NewElement - element to copy onto the top of the stack
+     * @return false if a new segment was needed and couldn't be allocated
+     */
+    bool Push(const ElementType& NewElement)
+    {
+        if (Top == nullptr || Top->Num == Top->Capacity)
         {
-            //this should realistically never happen, so exiting the application is appropriate
-            fprintf(stderr, "%s:%d: DynamicSet::DynamicSet: error constructing dyset, initial allocation failed. exiting.\n", __FILE__, __LINE__);
-            exit(STACK_ALLOCATION_FAILURE);
+            if (!Advance())
+            {
+                return false;
+            }
         }
-        MaxElements = ExpansionSize;
+
+        new (&Top->Elements[Top->Num++]) ElementType(NewElement);
+        NumElements++;
+        return true;
     }
 
-    ~Stack()
+    /** Pop
+     * @param OutElement - receives the element removed from the top of the stack
+     * @return false if the stack was empty, leaving OutElement untouched
+     */
+    bool Pop(ElementType& OutElement)
     {
-        if(Elements != nullptr)
+        if (NumElements == 0)
+        {
+            return false;
+        }
+
+        //segments below the top are always full, so an empty top segment means stepping down one
+        if (Top->Num == 0)
         {
-            free(Elements);
-            Elements = nullptr;
+            Top = Top->Previous;
         }
+
+        ElementType& Element = Top->Elements[--Top->Num];
+        OutElement = std::move(Element);
+        Element.~ElementType();
+        NumElements--;
+        return true;
     }
 
-    void Push(const ElementType& NewElement)
+    //removes every element, keeping the segments for reuse
+    void Clear()
     {
-        if(NumElements == NumAllocations * ExpansionSize)
+        for (Segment* Current = NumElements > 0 ? First : nullptr; Current != nullptr;
+             Current = Current == Top ? nullptr : Current->Next)
         {
-            Expand();
+            for (size_t i = 0; i < Current->Num; i++)
+            {
+                Current->Elements[i].~ElementType();
+            }
+            Current->Num = 0;
         }
+        NumElements = 0;
+        Top = First;
+    }
 
-        Elements[NumElements++] = NewElement;
-    };
+    /** ForEach
+     * Calls Visit with every element, from the bottom of the stack to the top
+     */
+    template<typename FunctionType>
+    void ForEach(FunctionType&& Visit) const
+    {
+        for (const Segment* Current = NumElements > 0 ? First : nullptr; Current != nullptr;
+             Current = Current == Top ? nullptr : Current->Next)
+        {
+            for (size_t i = 0; i < Current->Num; i++)
+            {
+                Visit(Current->Elements[i]);
+            }
+        }
+    }
 
-    ElementType Pop()
+    bool IsEmpty() const { return NumElements == 0; }
+    size_t Num() const { return NumElements; }
+
+private:
+    struct Segment
     {
-        return Elements[--NumElements];
+        Segment* Previous;
+        Segment* Next;
+        ElementType* Elements;
+        size_t Capacity;
+        size_t Num;
     };
 
-private:
+    //moves Top to the next segment, reusing one from an earlier deep push, or from a destroyed stack, if there is one
+    bool Advance()
+    {
+        Segment* Next = Top != nullptr ? Top->Next : First;
+        if (Next == nullptr)
+        {
+            const size_t Capacity = Top != nullptr ? Top->Capacity * 2 : InitialCapacity;
+            Next = SourceArena == nullptr ? TakeFreeSegment(Capacity) : nullptr;
+            if (Next == nullptr)
+            {
+                Arena& Source = SourceArena != nullptr ? *SourceArena : Arena::GetThreadArena();
+                Next = Source.AllocateArray<Segment>(1);
+                ElementType* Elements = Source.AllocateArray<ElementType>(Capacity);
+                if (Next == nullptr || Elements == nullptr)
+                {
+                    return false;
+                }
+                *Next = {nullptr, nullptr, Elements, Capacity, 0};
+            }
 
-    void Expand()
+            Next->Previous = Top;
+            Next->Next = nullptr;
+            Next->Num = 0;
+            if (Top != nullptr)
+            {
+                Top->Next = Next;
+            }
+            else
+            {
+                First = Next;
+                ChainArena = SourceArena == nullptr ? &Arena::GetThreadArena() : nullptr;
+            }
+        }
+
+        Top = Next;
+        return true;
+    }
+
+    //takes a segment of at least Capacity elements from the thread's free list
+    static Segment* TakeFreeSegment(const size_t Capacity)
     {
-        NumAllocations++;
-        auto* reallocdat = static_cast<ElementType*>(realloc(Elements, ExpansionSize * NumAllocations * sizeof(ElementType)));
-        if (reallocdat != nullptr)
+        for (Segment** Link = &FreeSegments; *Link != nullptr; Link = &(*Link)->Next)
         {
-            Elements = reallocdat;
-            MaxElements = NumAllocations * ExpansionSize;
+            if ((*Link)->Capacity >= Capacity)
+            {
+                Segment* Taken = *Link;
+                *Link = Taken->Next;
+                return Taken;
+            }
         }
-        else
+        return nullptr;
+    }
+
+    //hands the segments, which must be empty, to the thread's free list if they came from its arena. A stack
+    //destroyed on another thread leaves them to the arena of the thread it grew on
+    void Release()
+    {
+        if (SourceArena == nullptr && ChainArena == &Arena::GetThreadArena())
         {
-            //this should realistically never happen, so exiting the application is appropriate
-            fprintf(stderr, "%s:%d: DynamicSet::Expand: error re-allocating element array. exiting\n", __FILE__, __LINE__);
-            exit(STACK_ALLOCATION_FAILURE);
+            while (First != nullptr)
+            {
+                Segment* Next = First->Next;
+                First->Next = FreeSegments;
+                FreeSegments = First;
+                First = Next;
+            }
         }
+        First = nullptr;
+        Top = nullptr;
     }
 
-    ElementType* Elements = nullptr;
-    int MaxElements = 0;
-    int NumElements = 0;
-    int NumAllocations = 1;
-    const int ExpansionSize = 1024;
+    static constexpr size_t InitialCapacity = 64;
+
+    //segments of destroyed stacks of this type, linked through Next, per thread as each thread has its own arena
+    static inline thread_local Segment* FreeSegments = nullptr;
+
+    Arena* SourceArena = nullptr;
+    //thread arena the chain's segments came from, when they didn't come from SourceArena
+    Arena* ChainArena = nullptr;
+    //first segment of the chain, and the segment holding the top element
+    Segment* First = nullptr;
+    Segment* Top = nullptr;
+    size_t NumElements = 0;
 };
@@ -0,0 +1,32 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/* TriangulationScratch
+ * Working storage for TriangulatePolygon, kept by the caller so triangulating many polygons reuses it
+ */
+struct TriangulationScratch
+{
+    std::vector<glm::vec2> Projected;
+    std::vector<uint32_t> Original;
+    std::vector<uint32_t> Previous;
+    std::vector<uint32_t> Next;
+};
+
+/** TriangulatePolygon
+ * Ear clips a simple polygon, convex or concave, in the plane it lies in
+ * Consecutive duplicate vertices are skipped, and polygons which aren't quite planar or simple still produce triangles
+ * @param Vertices - the polygon's vertices, in order
+ * @param NumVertices - number of vertices
+ * @param Indices - receives three indices into Vertices per triangle, wound the same way as the polygon
+ * @param Normal - receives the unit normal of the polygon's plane, facing the side the polygon winds counterclockwise
+ * @param Scratch - working storage, its contents are overwritten
+ * @return false if the polygon has no area
+ */
+bool TriangulatePolygon(const glm::vec3* Vertices, size_t NumVertices, std::vector<uint32_t>& Indices, glm::vec3& Normal, TriangulationScratch& Scratch);
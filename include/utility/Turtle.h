@@ -3,44 +3,89 @@
 //
 #pragma once
 
+#include <cstdint>
 #include <vector>
-#include "Transform.h"
+#include "TurtleFrame.h"
 #include "rendering/ColoredTriangle.h"
+#include "rendering/ConeSegment.h"
+#include "rendering/Surface.h"
+#include "utility/Triangulate.h"
 #include "lindenmayer/lindenmayer.h"
 #include "Stack.h"
 
+/* ETurtleOp
+ * What the turtle does for a symbol. Symbols are mapped to operations through a 256 entry table, so the interpreter
+ * dispatches on a small dense enum, and symbols without an interpretation are skipped with a single lookup
+ */
+enum class ETurtleOp : uint8_t
+{
+    None,
+    DrawForward,
+    DrawForwardNoRecord,
+    MoveForward,
+    YawLeft,
+    YawRight,
+    PitchDown,
+    PitchUp,
+    RollLeft,
+    RollRight,
+    TurnAround,
+    RotateToVertical,
+    StartBranch,
+    CompleteBranch,
+    CutOffBranch,
+    StartPolygon,
+    RecordVertex,
+    CompletePolygon,
+    PredefinedSurface,
+    DecrementWidth,
+    IncrementColorIndex,
+};
+
 /* Turtle class
  * used for interpreting and drawing L-Systems
  */
 class Turtle
 {
 public:
+    //most triangles a drawing holds, segments past it are dropped
+    static constexpr unsigned int MaxTriangles = 10000000;
+
     Turtle()=default;
 
     void Reset();
-    void MoveForward(float Distance);
+
+    /** Turtle::MoveForward
+     * @param Distance - distance to move
+     * @param bRecordVertex - whether to add the new location to the polygon being defined, if any
+     */
+    void MoveForward(float Distance, bool bRecordVertex = true);
 
     //special movement
     void TurnAround();
     void RotateToVertical();
 
-    //branch management
-    void StartBranch();
+    //branch management, BranchStart is the index of the '[' starting the branch
+    void StartBranch(int BranchStart);
     void CompleteBranch();
-    //void CutOffRemainderOfBranch();
-
-    //move and draw commands
-    //void MoveForwardAndDraw();
 
     //polygon creation
     void StartPolygon();
-    //void RecordVertex();
-    //void DrawForwardNoRecord();
-    void CompletePolygon(ColoredTriangleList* triangles);
+    void RecordVertex();
+    void CompletePolygon();
 
-    //void IncorporatePredefinedSurface();
-    //void DecrementSegmentDiameter();
-    //void IncrementColorIndex();
+    /** Turtle::IncorporatePredefinedSurface
+     * Records an instance of a surface at the turtle's location, oriented along its heading
+     * @param SurfaceName - the symbol naming the surface, i.e. X for ~X
+     * @param Scale - size of the surface
+     */
+    void IncorporatePredefinedSurface(char SurfaceName, float Scale);
+    void DecrementSegmentDiameter();
+
+    /** Turtle::IncrementColorIndex
+     * @param NewIndex - index to jump to, or -1 to advance to the next color
+     */
+    void IncrementColorIndex(int NewIndex = -1);
 
     /** Turtle::DrawSystem
      * @param System - the system to draw
@@ -48,29 +93,119 @@ public:
      * @return A list of ColoredTriangles
      */
     void DrawSystem(LSystem& System, ColoredTriangleList** List);
-    void DrawConeSegment(float r1, float r2, glm::vec3& color1, glm::vec3& color2, float length, ColoredTriangleList* triangles) const;
+
+    /** Turtle::ResumeSystem
+     * Redraws System from the last checkpoint at or before FirstChangedSymbol, keeping what was drawn before it, for
+     * when only the string past FirstChangedSymbol has changed since the last drawing into List. Draws everything
+     * again if there is no such checkpoint
+     * @param System - the system to draw
+     * @param List - the list the last drawing was made into
+     * @param FirstChangedSymbol - position of the first symbol that may have changed
+     * @return position drawing resumed from
+     */
+    size_t ResumeSystem(LSystem& System, ColoredTriangleList** List, size_t FirstChangedSymbol);
+
+    /** Turtle::SetCheckpointInterval
+     * Records the turtle's state every Interval symbols of the following drawings, so they can be resumed part way.
+     * A checkpoint is taken at the first symbol outside any polygon once Interval symbols have passed since the last
+     * @param Interval - symbols between checkpoints, 0 to record none
+     */
+    void SetCheckpointInterval(size_t Interval) { CheckpointInterval = Interval; }
+
+    /** Turtle::DrawConeSegment
+     * Adds a cone along the turtle's heading to triangles, and records it in Segments
+     * @return false if the list has no room left for the cone, in which case nothing is added
+     */
+    bool DrawConeSegment(float r1, float r2, glm::vec3& color1, glm::vec3& color2, float length, ColoredTriangleList* triangles);
 
     //whether we are currently defining a polygon or not
     bool bIsDefiningPolygon = false;
-    //transform when polygon was started via { character
-    Transform PolygonStartTransform;
-    //vertices in the current polygon
-    std::vector<glm::vec3> polygonVertices;
+    //vertices of the polygons being defined, one list per nested {, the innermost at PolygonDepth - 1
+    std::vector<std::vector<glm::vec3>> PolygonStack;
+    size_t PolygonDepth = 0;
+    //triangulation of the last completed polygon
+    std::vector<uint32_t> PolygonIndices;
+    glm::vec3 PolygonNormal = glm::vec3(0.0f);
+    //working storage of the triangulator, reused for every polygon
+    TriangulationScratch PolygonScratch;
+    //polygon triangles, appended to the triangle list after everything else has been drawn
+    std::vector<ColoredTriangle> TwoSidedTriangles;
+    //every cone drawn, in order, the one sided triangles being FullDetailSides * 2 per segment
+    std::vector<ConeSegment> Segments;
 
     //current width being used when rendering conical sections
     float CurrentWidth = 1.0;
-    //current transform of the turtle
-    Transform CurrentTransform;
-    //current color used when adding triangles
+    //current position and orientation of the turtle
+    TurtleFrame CurrentFrame;
+    //current color used when adding triangles, looked up from the palette color and hue step
     glm::vec3 CurrentColor = glm::vec3(1.0, 0.0, 0.0);
+    //index into the color palette, advanced by ' and `
+    int ColorIndex = 0;
+    //steps the hue has advanced from the palette color, one per segment
+    uint8_t HueStep = 0;
+    //index of the '[' starting the current branch, -1 outside of any branch
+    int CurrentBranchStart = -1;
 
-    //state data for branches
+    //state saved by [ and restored by ], only what the turtle can change inside a branch
     struct StateData
     {
-        bool bIsDefiningPolygon = false;
-        float CurrentWidth;
-        Transform CurrentTransform;
-        glm::vec3 CurrentColor;
+        TurtleFrame Frame;
+        float Width;
+        int32_t BranchStart;
+        uint8_t ColorIndex;
+        uint8_t HueStep;
+        bool bIsDefiningPolygon;
+        uint16_t PolygonDepth;
     };
     Stack<StateData> BranchStack;
+
+    /* Checkpoint
+     * The turtle's state before the symbol at Position, and how much it had drawn by then. Its branch stack is the
+     * BranchDepth entries of CheckpointBranchStates from FirstBranchState, bottom first
+     */
+    struct Checkpoint
+    {
+        size_t Position;
+        size_t ParameterOffset;
+        TurtleFrame Frame;
+        float Width;
+        int32_t BranchStart;
+        int ColorIndex;
+        uint8_t HueStep;
+        bool bIsDefiningPolygon;
+        uint32_t BranchDepth;
+        size_t FirstBranchState;
+        long long NumTriangles;
+        glm::vec3 BoundingBoxMin;
+        glm::vec3 BoundingBoxMax;
+        size_t NumSegments;
+        size_t NumTwoSidedTriangles;
+        size_t NumSurfaceInstances;
+    };
+    std::vector<Checkpoint> Checkpoints;
+    std::vector<StateData> CheckpointBranchStates;
+    size_t CheckpointInterval = 0;
+
+    //names of the surface instances in the order they were placed, so those placed after a checkpoint can be removed
+    std::vector<unsigned char> SurfaceInstanceOrder;
+
+    //predefined surfaces placed by ~X, by surface name
+    std::vector<SurfaceInstance> SurfaceInstances[128];
+
+    /** Turtle::Interpret
+     * Draws the string of System from the symbol at Start on, with the turtle in the state it had before that symbol
+     * @param ParameterOffset - offset of the symbol's parameters in the parameter stream
+     */
+    void Interpret(LSystem& System, ColoredTriangleList* Triangles, size_t Start, size_t ParameterOffset);
+
+    //records the turtle's state before the symbol at Position
+    void RecordCheckpoint(size_t Position, size_t ParameterOffset, const ColoredTriangleList* Triangles);
+
+    //sets the current color to the palette color at the current hue step
+    void UpdateColor();
+
+    //index of matching brackets in the string being drawn, built the first time a branch is cut off
+    std::vector<int> BracketMatch;
+    //offset of each symbol's parameters, built alongside BracketMatch for parametric strings
+    std::vector<uint32_t> ParameterOffsets;
 };
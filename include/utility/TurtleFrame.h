@@ -0,0 +1,44 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#pragma once
+
+#include "Transform.h"
+
+/* TurtleFrame
+ * Position and orientation of the turtle, a location and a unit quaternion and nothing else
+ * Unlike Transform there is no scale or cached matrix, so saving and restoring it at every branch copies 28 bytes.
+ * Matrices are only built on the rendering side, from the geometry the turtle produces
+ */
+struct TurtleFrame
+{
+    glm::vec3 Location = glm::vec3(0.0f);
+    glm::quat Rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+    void Reset()
+    {
+        Location = glm::vec3(0.0f);
+        Rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    //heading, and the turtle's right and up directions, in the same axes as Transform
+    glm::vec3 GetForwardVector() const { return glm::normalize(Rotation * Transform::WorldForward); }
+    glm::vec3 GetRightVector() const { return glm::normalize(Rotation * Transform::WorldRight); }
+    glm::vec3 GetUpVector() const { return glm::normalize(Rotation * Transform::WorldUp); }
+
+    /** TurtleFrame::RotateLocal
+     * @param AxisOfRotation - axis in world space
+     * @param Degrees - angle to rotate by
+     */
+    void RotateLocal(const glm::vec3& AxisOfRotation, const float Degrees)
+    {
+        const glm::quat RotationQuat = glm::angleAxis(glm::radians(Degrees), glm::normalize(AxisOfRotation));
+        Rotation = glm::normalize(RotationQuat * Rotation);
+    }
+
+    //rotations about the turtle's own up, right and forward directions
+    void AdjustYaw(const float Angle) { RotateLocal(GetUpVector(), Angle); }
+    void AdjustPitch(const float Angle) { RotateLocal(GetRightVector(), Angle); }
+    void AdjustRoll(const float Angle) { RotateLocal(GetForwardVector(), Angle); }
+};
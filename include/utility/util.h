@@ -4,8 +4,8 @@
 
 #pragma once
 
-#include <vector>
 #include "glm.hpp"
+#include "utility/Arena.h"
 
 //take an HSV-based glm::vec3 and return an RGB based glm::vec3
 glm::vec3 HSVtoRGB(const glm::vec3& hsv);
@@ -13,5 +13,9 @@ glm::vec3 HSVtoRGB(const glm::vec3& hsv);
 //take an RGB-based glm::vec3 and return an HSV based glm::vec3
 glm::vec3 RGBtoHSV(const glm::vec3& rgb);
 
-//
-std::vector<glm::vec3> GenerateSphere(glm::vec3 Center, float Radius, unsigned int LongitudeSegments, unsigned int LatitudeSegments);
+/** GenerateSphere
+ * @param Memory - arena the vertices are allocated from
+ * @param NumVertices - receives the number of vertices, three per triangle
+ * @return the sphere's triangles, or nullptr if the arena couldn't allocate them
+ */
+glm::vec3* GenerateSphere(glm::vec3 Center, float Radius, unsigned int LongitudeSegments, unsigned int LatitudeSegments, Arena& Memory, int& NumVertices);
@@ -6,10 +6,19 @@ in vec3 normal;
 
 out vec4 frag_colour;
 
-uniform vec3 lightPosition;
-uniform vec3 lightColor;
-uniform vec3 ambientColor;
-uniform float ambientStrength;
+// per frame state shared by every program, laid out to match Rendering::GlobalUniforms
+layout(std140) uniform GlobalUniforms
+{
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    mat4 ViewProjectionMatrix;
+    vec3 lightPosition;
+    vec3 lightColor;
+    vec3 ambientColor;
+    float ambientStrength;
+};
+
+uniform bool twoSided;
 
 void main()
 {
@@ -17,7 +26,8 @@ void main()
     vec3 ambient = ambientStrength * ambientColor;
 
     // Diffuse lighting
-    vec3 norm = normalize(normal);
+    // Two-sided geometry is lit along the flipped normal when seen from behind
+    vec3 norm = normalize(twoSided && !gl_FrontFacing ? -normal : normal);
     vec3 lightDir = normalize(lightPosition - fragPosition);
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = diff * lightColor;
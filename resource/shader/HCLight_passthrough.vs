@@ -4,7 +4,17 @@ layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec3 vertexColor;
 layout(location = 2) in vec3 vertexNormal;
 
-uniform mat4 ViewProjectionMatrix;
+// per frame state shared by every program, laid out to match Rendering::GlobalUniforms
+layout(std140) uniform GlobalUniforms
+{
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    mat4 ViewProjectionMatrix;
+    vec3 lightPosition;
+    vec3 lightColor;
+    vec3 ambientColor;
+    float ambientStrength;
+};
 
 out vec3 color;
 out vec3 fragPosition;
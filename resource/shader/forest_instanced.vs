@@ -0,0 +1,42 @@
+#version 400
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec3 vertexColor;
+layout(location = 2) in vec3 vertexNormal;
+
+// per plant placement, a location and scale, and a tint with the yaw about the world's up axis
+layout(location = 3) in vec4 instanceLocationScale;
+layout(location = 4) in vec4 instanceTintYaw;
+
+// per frame state shared by every program, laid out to match Rendering::GlobalUniforms
+layout(std140) uniform GlobalUniforms
+{
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    mat4 ViewProjectionMatrix;
+    vec3 lightPosition;
+    vec3 lightColor;
+    vec3 ambientColor;
+    float ambientStrength;
+};
+
+out vec3 color;
+out vec3 fragPosition;
+out vec3 normal;
+
+void main()
+{
+    color = vertexColor * instanceTintYaw.rgb;
+
+    // Transform vertex position from the plant's own space to world space
+    float c = cos(instanceTintYaw.w);
+    float s = sin(instanceTintYaw.w);
+    mat3 yaw = mat3(c, 0.0, -s,
+                    0.0, 1.0, 0.0,
+                    s, 0.0, c);
+    fragPosition = instanceLocationScale.xyz + yaw * (vertexPosition * instanceLocationScale.w);
+
+    normal = yaw * vertexNormal;
+
+    gl_Position = ViewProjectionMatrix * vec4(fragPosition, 1.0);
+};
@@ -0,0 +1,43 @@
+#version 400
+
+in vec3 color;
+in vec3 fragPosition;
+in vec3 normal;
+
+out vec4 frag_colour;
+
+// per frame state shared by every program, laid out to match Rendering::GlobalUniforms
+layout(std140) uniform GlobalUniforms
+{
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    mat4 ViewProjectionMatrix;
+    vec3 lightPosition;
+    vec3 lightColor;
+    vec3 ambientColor;
+    float ambientStrength;
+};
+
+uniform bool litMode;
+
+void main()
+{
+    if (!litMode)
+    {
+        frag_colour = vec4(color, 1.0);
+        return;
+    }
+
+    // Ambient lighting
+    vec3 ambient = ambientStrength * ambientColor;
+
+    // Diffuse lighting, surfaces are visible from both sides so back faces are lit along the flipped normal
+    vec3 norm = normalize(gl_FrontFacing ? normal : -normal);
+    vec3 lightDir = normalize(lightPosition - fragPosition);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * lightColor;
+
+    // Combine lighting with object color
+    vec3 lighting = max(ambient, diffuse) * color;
+    frag_colour = vec4(lighting, 1.0);
+};
@@ -0,0 +1,40 @@
+#version 400
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 2) in vec3 vertexNormal;
+
+// per instance turtle frame, surfaces are modelled with x to the turtle's right, y along its heading, and z up
+layout(location = 3) in vec4 instanceLocationScale;
+layout(location = 4) in vec3 instanceRight;
+layout(location = 5) in vec3 instanceUp;
+layout(location = 6) in vec3 instanceForward;
+layout(location = 7) in vec3 instanceColor;
+
+// per frame state shared by every program, laid out to match Rendering::GlobalUniforms
+layout(std140) uniform GlobalUniforms
+{
+    mat4 ViewMatrix;
+    mat4 ProjectionMatrix;
+    mat4 ViewProjectionMatrix;
+    vec3 lightPosition;
+    vec3 lightColor;
+    vec3 ambientColor;
+    float ambientStrength;
+};
+
+out vec3 color;
+out vec3 fragPosition;
+out vec3 normal;
+
+void main()
+{
+    color = instanceColor;
+
+    // Transform vertex position from the turtle's frame to world space
+    mat3 frame = mat3(instanceRight, instanceForward, instanceUp);
+    fragPosition = instanceLocationScale.xyz + frame * (vertexPosition * instanceLocationScale.w);
+
+    normal = frame * vertexNormal;
+
+    gl_Position = ViewProjectionMatrix * vec4(fragPosition, 1.0);
+};
@@ -4,12 +4,18 @@
 #include "UI/UIManager.h"
 
 #include <lindenmayer/lindenmayer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <string>
 
 #include "../lib/imgui/imgui.h"
 #include "../lib/imgui/backends/imgui_impl_glfw.h"
 #include "../lib/imgui/backends/imgui_impl_opengl3.h"
 #include "myc/paths/paths.h"
+#include "myc/logging/logging.h"
+#include "utility/Profiler.h"
+#include "utility/Turtle.h"
 
 void UIManager::Init(GLFWwindow* window)
 {
@@ -50,6 +56,15 @@ void UIManager::SetLightUpdateCallback(void (* LightUpdateCallbackSignature)())
     LightUpdateCallback = LightUpdateCallbackSignature;
 }
 
+void UIManager::SetForestCallbacks(void (* UpdateCallbackSignature)(),
+                                   void (* AddSpeciesCallbackSignature)(),
+                                   void (* ClearCallbackSignature)())
+{
+    ForestUpdateCallback = UpdateCallbackSignature;
+    ForestAddSpeciesCallback = AddSpeciesCallbackSignature;
+    ForestClearCallback = ClearCallbackSignature;
+}
+
 void SliderWithTextInput(const char* label, float* value, const float min, const float max)
 {
     static float textValue = 0.0f;       // Temporary value for text input
@@ -86,17 +101,67 @@ void SliderWithTextInput(const char* label, float* value, const float min, const
     ImGui::PopID(); // Restore ID stack
 }
 
+//writes a byte count with a binary unit, 4.3 GB rather than 4617089843
+static void FormatBytes(const double Bytes, char* Buffer, const size_t BufferSize)
+{
+    static const char* Units[] = {"B", "KB", "MB", "GB", "TB", "PB"};
+    double Scaled = Bytes;
+    int Unit = 0;
+    while (Scaled >= 1024.0 && Unit + 1 < static_cast<int>(IM_ARRAYSIZE(Units)))
+    {
+        Scaled /= 1024.0;
+        Unit++;
+    }
+    snprintf(Buffer, BufferSize, Unit == 0 ? "%.0f %s" : "%.1f %s", Scaled, Units[Unit]);
+}
+
+//writes a count with a decimal suffix, 1.2M rather than 1234567
+static void FormatCount(const double Count, char* Buffer, const size_t BufferSize)
+{
+    static const char* Suffixes[] = {"", "K", "M", "G", "T", "P", "E"};
+    double Scaled = Count;
+    int Suffix = 0;
+    while (Scaled >= 1000.0 && Suffix + 1 < static_cast<int>(IM_ARRAYSIZE(Suffixes)))
+    {
+        Scaled /= 1000.0;
+        Suffix++;
+    }
+    if (Scaled >= 1000.0)
+    {
+        snprintf(Buffer, BufferSize, "%.2e", Count);
+        return;
+    }
+    snprintf(Buffer, BufferSize, Suffix == 0 ? "%.0f%s" : "%.1f%s", Scaled, Suffixes[Suffix]);
+}
+
+//most generations the statistics table predicts one by one
+static constexpr int MaxTabulatedGenerations = 64;
+
 void UIManager::DrawSystemMenu(LSystem* ActiveSystem) const
 {
     ImGui::Begin("L-System Configuration"); // Start a new window
 
     // System Name
-    static char systemName[64] = "Default System";
-    ImGui::InputText("System Name", ActiveSystem->Name, IM_ARRAYSIZE(systemName));
+    ImGui::InputText("System Name", ActiveSystem->Name, IM_ARRAYSIZE(ActiveSystem->Name));
 
     bool bSignificantChangeDetected = false;
-    // Iteration Count
-    bSignificantChangeDetected |= ImGui::SliderInt("Iteration Count", &ActiveSystem->Iterations, 0, 10);
+    // Iteration Count, set through SetIterations so the memory budget holds
+    int NewIterations = ActiveSystem->Iterations;
+    if (ImGui::SliderInt("Iteration Count", &NewIterations, 0, 10))
+    {
+        ActiveSystem->SetIterations(NewIterations);
+        bSignificantChangeDetected = true;
+    }
+
+    //what the chosen iteration will cost, predicted before it's generated. The table covers at least the chosen
+    //iteration, up to a limit, past which the headline comes from the fast-forwarded prediction alone
+    if (ActiveSystem->GetContentHash() != StatsHash || GenerationStats.empty())
+    {
+        ActiveSystem->PredictGenerations(std::min(std::max(10, ActiveSystem->Iterations), MaxTabulatedGenerations), GenerationStats);
+        CurrentGrowth = ActiveSystem->PredictGeneration(ActiveSystem->Iterations);
+        StatsHash = ActiveSystem->GetContentHash();
+    }
+    DrawGenerationStats(ActiveSystem);
 
     // Angle
     bSignificantChangeDetected |= ImGui::SliderFloat("Angle", &ActiveSystem->Angle, 0.0f, 360.0f);
@@ -108,19 +173,49 @@ void UIManager::DrawSystemMenu(LSystem* ActiveSystem) const
     bSignificantChangeDetected |= ImGui::SliderFloat("Distance", &ActiveSystem->Distance, 0.1f, 10.0f);
 
     // Axiom
-    static char axiom[64] = "F";
-    bSignificantChangeDetected |= ImGui::InputText("Axiom", ActiveSystem->Axiom, IM_ARRAYSIZE(axiom));
+    bSignificantChangeDetected |= ImGui::InputText("Axiom", ActiveSystem->Axiom, IM_ARRAYSIZE(ActiveSystem->Axiom));
 
-    //list rules
+    // Seed, used by stochastic rules
+    bSignificantChangeDetected |= ImGui::InputScalar("Seed", ImGuiDataType_U32, &ActiveSystem->Seed);
+
+    // Symbols skipped over when matching the contexts of context-sensitive rules
+    char Ignored[256] = {0};
+    strncat(Ignored, ActiveSystem->IgnoredSymbolsString.c_str(), sizeof(Ignored) - 1);
+    if(ImGui::InputText("Ignore", Ignored, IM_ARRAYSIZE(Ignored)))
+    {
+        ActiveSystem->SetIgnoredSymbols(Ignored);
+        bSignificantChangeDetected = true;
+    }
+
+    //list rules, stochastic rules list each alternative along with its weight
     int Count = 0;
     for(LS_RewritingRule& Rule : ActiveSystem->RewritingRules)
     {
-        if(Rule.Character != ' ')
+        for(int i = 0; i < Rule.NumSuccessors; i++)
         {
-            ImGui::Text("Rule %c:", Rule.Character);
+            LS_Successor& Successor = Rule.Successors[i];
+            ImGui::Text("Rule %s:", Rule.PredecessorString);
             ImGui::SameLine();
             ImGui::PushID(Count);
-            if(ImGui::InputText("##replacement", Rule.RString, MaxReplacementLength))
+            if(Rule.ConditionString[0] != '\0')
+            {
+                ImGui::SetNextItemWidth(80);
+                if(ImGui::InputText("##condition", Rule.ConditionString, MaxReplacementLength))
+                {
+                    bSignificantChangeDetected |= true;
+                }
+                ImGui::SameLine();
+            }
+            if(Rule.bStochastic)
+            {
+                ImGui::SetNextItemWidth(60);
+                if(ImGui::DragFloat("##weight", &Successor.Weight, 0.01f, 0.0f, 100.0f, "%.2f"))
+                {
+                    bSignificantChangeDetected |= true;
+                }
+                ImGui::SameLine();
+            }
+            if(ImGui::InputText("##replacement", Successor.RString, MaxReplacementLength))
             {
                 bSignificantChangeDetected |= true;
             }
@@ -139,7 +234,7 @@ void UIManager::DrawSystemMenu(LSystem* ActiveSystem) const
     ImGui::InputText("Replacement", NewRuleReplacementBuf, MaxReplacementLength);
     if(ImGui::Button("Add Rule"))
     {
-        if(ActiveSystem->RewritingRules[static_cast<unsigned char>(NewRuleCharacterBuf)].Character != NewRuleCharacterBuf)
+        if(!ActiveSystem->HasRule(NewRuleCharacterBuf))
         {
             ActiveSystem->AddRule(NewRuleCharacterBuf, NewRuleReplacementBuf);
         }
@@ -169,6 +264,142 @@ void UIManager::DrawSystemMenu(LSystem* ActiveSystem) const
     ImGui::End(); // End the window
 }
 
+void UIManager::DrawGenerationStats(const LSystem* ActiveSystem) const
+{
+    if (GenerationStats.empty())
+    {
+        return;
+    }
+
+    //iterations past the table are only predicted by fast-forwarding, which has no breakdown of their memory
+    const int Iteration = std::max(ActiveSystem->Iterations, 0);
+    const bool bTabulated = Iteration < static_cast<int>(GenerationStats.size());
+    const LS_GenerationStats& Current = GenerationStats[bTabulated ? Iteration : GenerationStats.size() - 1];
+
+    char Length[32];
+    char Triangles[32];
+    char Memory[32];
+    FormatCount(bTabulated ? Current.Length : CurrentGrowth.GetLength(), Length, sizeof(Length));
+    FormatCount(bTabulated ? Current.NumTriangles : exp2(CurrentGrowth.Log2NumTriangles), Triangles, sizeof(Triangles));
+    FormatBytes(bTabulated ? Current.GetTotalBytes() : CurrentGrowth.GetTotalBytes(), Memory, sizeof(Memory));
+
+    //generations too big to generate in full are shown in red, estimates are marked with a ~
+    const bool bExact = bTabulated ? Current.bExact : CurrentGrowth.bExact;
+    const bool bWarn = bTabulated ? Current.bTruncated : CurrentGrowth.bTruncated;
+    if (bWarn)
+    {
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.4f, 0.3f, 1.0f));
+    }
+    ImGui::Text("iteration %d -> %s%s symbols, %s triangles, %s", Iteration, bExact ? "" : "~", Length, Triangles, Memory);
+    if (bWarn)
+    {
+        ImGui::PopStyleColor();
+    }
+    if (ImGui::IsItemHovered())
+    {
+        char StringBytes[32];
+        char GeometryBytes[32];
+        char VertexBytes[32];
+        FormatBytes(Current.StringBytes, StringBytes, sizeof(StringBytes));
+        FormatBytes(Current.GeometryBytes, GeometryBytes, sizeof(GeometryBytes));
+        FormatBytes(Current.VertexBytes, VertexBytes, sizeof(VertexBytes));
+        ImGui::BeginTooltip();
+        if (bTabulated)
+        {
+            ImGui::Text("string %s, turtle geometry %s, vertex buffers %s", StringBytes, GeometryBytes, VertexBytes);
+        }
+        ImGui::Text("grows %.2fx per iteration, rewriting takes about %.2g seconds", CurrentGrowth.GrowthRate,
+                    CurrentGrowth.EstimatedRewriteSeconds);
+        if (!bExact)
+        {
+            ImGui::Text("estimated, the system has stochastic, conditional or context-sensitive rules");
+        }
+        if (bWarn)
+        {
+            ImGui::Text("past the generator's limits of %zu symbols or %u triangles, it will be cut short",
+                        LSystem::MaxGeneratedLength, Turtle::MaxTriangles);
+        }
+        ImGui::EndTooltip();
+    }
+
+    if (!ImGui::TreeNode("Generation Statistics"))
+    {
+        return;
+    }
+
+    constexpr ImGuiTableFlags TableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+    if (ImGui::BeginTable("##generations", 6, TableFlags))
+    {
+        ImGui::TableSetupColumn("Iteration");
+        ImGui::TableSetupColumn("Symbols");
+        ImGui::TableSetupColumn("Depth");
+        ImGui::TableSetupColumn("Segments");
+        ImGui::TableSetupColumn("Triangles");
+        ImGui::TableSetupColumn("Memory");
+        ImGui::TableHeadersRow();
+
+        for (const LS_GenerationStats& Generation : GenerationStats)
+        {
+            char Segments[32];
+            FormatCount(Generation.Length, Length, sizeof(Length));
+            FormatCount(Generation.NumSegments, Segments, sizeof(Segments));
+            FormatCount(Generation.NumTriangles, Triangles, sizeof(Triangles));
+            FormatBytes(Generation.GetTotalBytes(), Memory, sizeof(Memory));
+
+            ImGui::TableNextRow();
+            if (Generation.Iteration == Iteration)
+            {
+                ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, ImGui::GetColorU32(ImGuiCol_Header));
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%d%s", Generation.Iteration, Generation.bTruncated ? " (cut)" : "");
+            ImGui::TableNextColumn();
+            ImGui::Text("%s%s", Generation.bExact ? "" : "~", Length);
+            ImGui::TableNextColumn();
+            ImGui::Text("%lld", Generation.MaxBracketDepth);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(Segments);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(Triangles);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(Memory);
+        }
+        ImGui::EndTable();
+    }
+
+    //symbols of the current iteration, most common first, shares of the fast-forwarded counts taken in the log
+    //domain as they may be past a double
+    ImGui::Text("Symbols at iteration %d", Iteration);
+    auto GetLog2Count = [&](const int Symbol)
+    {
+        return bTabulated ? (Current.SymbolCounts[Symbol] > 0.0 ? log2(Current.SymbolCounts[Symbol]) : -INFINITY)
+                          : CurrentGrowth.Log2SymbolCounts[Symbol];
+    };
+    const double Log2Length = bTabulated ? log2(Current.Length) : CurrentGrowth.Log2Length;
+    std::vector<int> Symbols;
+    for (int Symbol = 0; Symbol < 128; Symbol++)
+    {
+        if (GetLog2Count(Symbol) > -INFINITY)
+        {
+            Symbols.push_back(Symbol);
+        }
+    }
+    std::sort(Symbols.begin(), Symbols.end(), [&GetLog2Count](const int A, const int B)
+    {
+        return GetLog2Count(A) > GetLog2Count(B);
+    });
+    for (const int Symbol : Symbols)
+    {
+        const double Log2Count = GetLog2Count(Symbol);
+        char Overlay[48];
+        FormatCount(exp2(Log2Count), Length, sizeof(Length));
+        snprintf(Overlay, sizeof(Overlay), "%c  %s", static_cast<char>(Symbol), Length);
+        ImGui::ProgressBar(static_cast<float>(exp2(Log2Count - Log2Length)), ImVec2(-1.0f, 0.0f), Overlay);
+    }
+
+    ImGui::TreePop();
+}
+
 void UIManager::UpdateScale(float NewScale)
 {
     // Adjust style
@@ -285,4 +516,102 @@ void UIManager::DrawLightMenu() const
     ImGui::End(); // End the window
 }
 
+void UIManager::SetForestVariables(bool* bForestMode, int* NumPlants, float* Radius, int* Seed)
+{
+    ForestInfo.bForestMode = bForestMode;
+    ForestInfo.NumPlants = NumPlants;
+    ForestInfo.Radius = Radius;
+    ForestInfo.Seed = Seed;
+}
+
+void UIManager::DrawForestMenu(const int NumSpecies, const size_t NumPlants) const
+{
+    if (ForestInfo.bForestMode == nullptr)
+    {
+        return;
+    }
+
+    ImGui::Begin("Forest");
+
+    //every change scatters the plants again, which only rewrites their placements
+    bool bChanged = ImGui::Checkbox("Forest Mode", ForestInfo.bForestMode);
+    bChanged |= ImGui::SliderInt("Plants", ForestInfo.NumPlants, 1, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+    bChanged |= ImGui::SliderFloat("Radius", ForestInfo.Radius, 1.0f, 500.0f);
+    bChanged |= ImGui::InputInt("Seed", ForestInfo.Seed);
+    if (bChanged && ForestUpdateCallback != nullptr)
+    {
+        ForestUpdateCallback();
+    }
+
+    if (ImGui::Button("Add Current System") && ForestAddSpeciesCallback != nullptr)
+    {
+        ForestAddSpeciesCallback();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Species") && ForestClearCallback != nullptr)
+    {
+        ForestClearCallback();
+    }
+
+    ImGui::Text("%d species, %zu plants", NumSpecies, NumPlants);
 
+    ImGui::End();
+}
+
+void UIManager::DrawProfilerMenu(const char* TraceFilename) const
+{
+    ImGui::Begin("Profiler");
+
+    Profiler* Stages = Profiler::Get();
+    const int HistoryOffset = Stages->GetHistoryOffset();
+    for (int Stage = 0; Stage < Stages->GetNumStages(); Stage++)
+    {
+        const float* History = Stages->GetHistory(Stage);
+        float Total = 0.0f;
+        float Max = 0.0f;
+        for (int i = 0; i < Profiler::HistoryLength; i++)
+        {
+            Total += History[i];
+            Max = History[i] > Max ? History[i] : Max;
+        }
+
+        char Overlay[96];
+        snprintf(Overlay, sizeof(Overlay), "%.3f ms, avg %.3f, max %.3f", Stages->GetLastFrameTime(Stage),
+                 Total / static_cast<float>(Profiler::HistoryLength), Max);
+
+        //history graphs share the label column with other windows' sliders
+        ImGui::PushID(Stage);
+        ImGui::PlotLines(Stages->GetStageName(Stage), History, Profiler::HistoryLength, HistoryOffset, Overlay, 0.0f,
+                         Max > 0.0f ? Max : 1.0f, ImVec2(0.0f, 40.0f));
+        ImGui::PopID();
+    }
+
+    if (ImGui::Button(Stages->IsCapturing() ? "Stop Capture" : "Start Capture"))
+    {
+        if (Stages->IsCapturing())
+        {
+            Stages->StopCapture();
+        }
+        else
+        {
+            Stages->StartCapture();
+        }
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(Stages->GetNumTraceEvents() == 0);
+    if (ImGui::Button("Export Trace"))
+    {
+        if (Stages->WriteChromeTrace(TraceFilename))
+        {
+            LogInfo("wrote %zu trace events to %s\n", Stages->GetNumTraceEvents(), TraceFilename);
+        }
+        else
+        {
+            LogError("could not write trace %s\n", TraceFilename);
+        }
+    }
+    ImGui::EndDisabled();
+    ImGui::Text("%zu events captured", Stages->GetNumTraceEvents());
+
+    ImGui::End();
+}
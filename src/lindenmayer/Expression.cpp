@@ -0,0 +1,383 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "lindenmayer/Expression.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include "myc/logging/logging.h"
+
+/* LS_Expression::Parser
+ * Recursive descent over the expression grammar, emitting postfix bytecode as it goes
+ *
+ *  Or         := And ('||' And)*
+ *  And        := Comparison ('&&' Comparison)*
+ *  Comparison := Additive (('<' | '>' | '<=' | '>=' | '==' | '=' | '!=') Additive)?
+ *  Additive   := Term (('+' | '-') Term)*
+ *  Term       := Unary (('*' | '/') Unary)*
+ *  Unary      := ('-' | '!') Unary | Power
+ *  Power      := Primary ('^' Unary)?
+ *  Primary    := Number | Name | '(' Or ')'
+ */
+class LS_Expression::Parser
+{
+public:
+    Parser(LS_Expression& InExpression,
+           const std::vector<std::string>& InParameterNames,
+           const std::vector<LS_Constant>& InConstants)
+        : Expression(InExpression), ParameterNames(InParameterNames), Constants(InConstants)
+    {
+        Cursor = Expression.Source.c_str();
+    }
+
+    bool Parse()
+    {
+        ParseOr();
+        SkipWhitespace();
+        if (!bFailed && *Cursor != '\0')
+        {
+            Fail("unexpected character");
+        }
+        return !bFailed;
+    }
+
+private:
+    void SkipWhitespace()
+    {
+        while (*Cursor == ' ' || *Cursor == '\t')
+        {
+            Cursor++;
+        }
+    }
+
+    //consumes Token if it's next in the input
+    bool Accept(const char* Token)
+    {
+        SkipWhitespace();
+        size_t i = 0;
+        while (Token[i] != '\0')
+        {
+            if (Cursor[i] != Token[i])
+            {
+                return false;
+            }
+            i++;
+        }
+        Cursor += i;
+        return true;
+    }
+
+    void Fail(const char* Reason)
+    {
+        if (!bFailed)
+        {
+            LogError("expression \"%s\": %s at \"%s\"\n", Expression.Source.c_str(), Reason, Cursor);
+        }
+        bFailed = true;
+    }
+
+    void ParseOr()
+    {
+        ParseAnd();
+        while (!bFailed && Accept("||"))
+        {
+            ParseAnd();
+            Expression.Emit(EOpCode::Or);
+        }
+    }
+
+    void ParseAnd()
+    {
+        ParseComparison();
+        while (!bFailed && Accept("&&"))
+        {
+            ParseComparison();
+            Expression.Emit(EOpCode::And);
+        }
+    }
+
+    void ParseComparison()
+    {
+        ParseAdditive();
+        if (bFailed)
+        {
+            return;
+        }
+
+        //longer tokens first, so "<=" isn't read as "<"
+        EOpCode Op;
+        if (Accept("<=")) { Op = EOpCode::LessEqual; }
+        else if (Accept(">=")) { Op = EOpCode::GreaterEqual; }
+        else if (Accept("==")) { Op = EOpCode::Equal; }
+        else if (Accept("!=")) { Op = EOpCode::NotEqual; }
+        else if (Accept("<")) { Op = EOpCode::Less; }
+        else if (Accept(">")) { Op = EOpCode::Greater; }
+        else if (Accept("=")) { Op = EOpCode::Equal; }
+        else { return; }
+
+        ParseAdditive();
+        Expression.Emit(Op);
+    }
+
+    void ParseAdditive()
+    {
+        ParseTerm();
+        while (!bFailed)
+        {
+            if (Accept("+"))
+            {
+                ParseTerm();
+                Expression.Emit(EOpCode::Add);
+            }
+            else if (Accept("-"))
+            {
+                ParseTerm();
+                Expression.Emit(EOpCode::Subtract);
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    void ParseTerm()
+    {
+        ParseUnary();
+        while (!bFailed)
+        {
+            if (Accept("*"))
+            {
+                ParseUnary();
+                Expression.Emit(EOpCode::Multiply);
+            }
+            else if (Accept("/"))
+            {
+                ParseUnary();
+                Expression.Emit(EOpCode::Divide);
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    void ParseUnary()
+    {
+        if (Accept("-"))
+        {
+            ParseUnary();
+            Expression.Emit(EOpCode::Negate);
+        }
+        else if (Accept("!"))
+        {
+            ParseUnary();
+            Expression.Emit(EOpCode::Not);
+        }
+        else
+        {
+            ParsePower();
+        }
+    }
+
+    void ParsePower()
+    {
+        ParsePrimary();
+        if (!bFailed && Accept("^"))
+        {
+            //right associative, and binds tighter than a unary minus on its left: -2^2 = -4
+            ParseUnary();
+            Expression.Emit(EOpCode::Power);
+        }
+    }
+
+    void ParsePrimary()
+    {
+        SkipWhitespace();
+
+        if (Accept("("))
+        {
+            ParseOr();
+            if (!bFailed && !Accept(")"))
+            {
+                Fail("expected ')'");
+            }
+            return;
+        }
+
+        if (isdigit(static_cast<unsigned char>(*Cursor)) || *Cursor == '.')
+        {
+            char* End = nullptr;
+            const float Value = strtof(Cursor, &End);
+            Cursor = End;
+            Expression.Emit(EOpCode::Constant, Value);
+            return;
+        }
+
+        if (isalpha(static_cast<unsigned char>(*Cursor)) || *Cursor == '_')
+        {
+            const char* NameStart = Cursor;
+            while (isalnum(static_cast<unsigned char>(*Cursor)) || *Cursor == '_')
+            {
+                Cursor++;
+            }
+            const std::string Name(NameStart, Cursor);
+
+            for (size_t i = 0; i < ParameterNames.size(); i++)
+            {
+                if (ParameterNames[i] == Name)
+                {
+                    Expression.Emit(EOpCode::Parameter, 0.0f, static_cast<uint8_t>(i));
+                    return;
+                }
+            }
+            for (const LS_Constant& Constant : Constants)
+            {
+                if (Constant.Name == Name)
+                {
+                    Expression.Emit(EOpCode::Constant, Constant.Value);
+                    return;
+                }
+            }
+
+            Cursor = NameStart;
+            Fail("unknown name");
+            return;
+        }
+
+        Fail("expected a number, name or '('");
+    }
+
+    LS_Expression& Expression;
+    const std::vector<std::string>& ParameterNames;
+    const std::vector<LS_Constant>& Constants;
+    const char* Cursor = nullptr;
+    bool bFailed = false;
+};
+
+bool LS_Expression::Compile(const std::string& NewSource,
+                            const std::vector<std::string>& ParameterNames,
+                            const std::vector<LS_Constant>& Constants)
+{
+    Source = NewSource;
+    Code.clear();
+
+    Parser ExpressionParser(*this, ParameterNames, Constants);
+    if (!ExpressionParser.Parse())
+    {
+        Code.clear();
+        Emit(EOpCode::Constant, 0.0f);
+        return false;
+    }
+
+    //make sure evaluation fits in the fixed size stack
+    int Depth = 0, MaxDepth = 0;
+    for (const Instruction& Instr : Code)
+    {
+        switch (Instr.Op)
+        {
+            case EOpCode::Constant:
+            case EOpCode::Parameter:
+                Depth++;
+            break;
+            case EOpCode::Negate:
+            case EOpCode::Not:
+            break;
+            default:
+                Depth--;
+            break;
+        }
+        MaxDepth = Depth > MaxDepth ? Depth : MaxDepth;
+    }
+
+    if (MaxDepth > MaxStackDepth)
+    {
+        LogError("expression \"%s\" is too deeply nested\n", Source.c_str());
+        Code.clear();
+        Emit(EOpCode::Constant, 0.0f);
+        return false;
+    }
+
+    return true;
+}
+
+float LS_Expression::Apply(const EOpCode Op, const float A, const float B)
+{
+    switch (Op)
+    {
+        case EOpCode::Add:          return A + B;
+        case EOpCode::Subtract:     return A - B;
+        case EOpCode::Multiply:     return A * B;
+        case EOpCode::Divide:       return A / B;
+        case EOpCode::Power:        return powf(A, B);
+        case EOpCode::Negate:       return -A;
+        case EOpCode::Less:         return A < B ? 1.0f : 0.0f;
+        case EOpCode::Greater:      return A > B ? 1.0f : 0.0f;
+        case EOpCode::LessEqual:    return A <= B ? 1.0f : 0.0f;
+        case EOpCode::GreaterEqual: return A >= B ? 1.0f : 0.0f;
+        case EOpCode::Equal:        return A == B ? 1.0f : 0.0f;
+        case EOpCode::NotEqual:     return A != B ? 1.0f : 0.0f;
+        case EOpCode::And:          return A != 0.0f && B != 0.0f ? 1.0f : 0.0f;
+        case EOpCode::Or:           return A != 0.0f || B != 0.0f ? 1.0f : 0.0f;
+        case EOpCode::Not:          return A == 0.0f ? 1.0f : 0.0f;
+        default:                    return 0.0f;
+    }
+}
+
+void LS_Expression::Emit(const EOpCode Op, const float Value, const uint8_t ParameterIndex)
+{
+    const size_t Size = Code.size();
+    const bool bUnary = Op == EOpCode::Negate || Op == EOpCode::Not;
+    const bool bBinary = !bUnary && Op != EOpCode::Constant && Op != EOpCode::Parameter;
+
+    //fold operators whose operands are all constants
+    if (bUnary && Size >= 1 && Code[Size - 1].Op == EOpCode::Constant)
+    {
+        Code[Size - 1].Value = Apply(Op, Code[Size - 1].Value, 0.0f);
+        return;
+    }
+    if (bBinary && Size >= 2 && Code[Size - 1].Op == EOpCode::Constant && Code[Size - 2].Op == EOpCode::Constant)
+    {
+        Code[Size - 2].Value = Apply(Op, Code[Size - 2].Value, Code[Size - 1].Value);
+        Code.pop_back();
+        return;
+    }
+
+    Instruction Instr;
+    Instr.Op = Op;
+    Instr.Value = Value;
+    Instr.ParameterIndex = ParameterIndex;
+    Code.push_back(Instr);
+}
+
+float LS_Expression::Evaluate(const float* Parameters) const
+{
+    float Stack[MaxStackDepth];
+    int Top = -1;
+
+    for (const Instruction& Instr : Code)
+    {
+        switch (Instr.Op)
+        {
+            case EOpCode::Constant:
+                Stack[++Top] = Instr.Value;
+            break;
+            case EOpCode::Parameter:
+                Stack[++Top] = Parameters[Instr.ParameterIndex];
+            break;
+            case EOpCode::Negate:
+            case EOpCode::Not:
+                Stack[Top] = Apply(Instr.Op, Stack[Top], 0.0f);
+            break;
+            default:
+                Stack[Top - 1] = Apply(Instr.Op, Stack[Top - 1], Stack[Top]);
+                Top--;
+            break;
+        }
+    }
+
+    return Top >= 0 ? Stack[Top] : 0.0f;
+}
@@ -0,0 +1,252 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "lindenmayer/GenerationIndex.h"
+
+#include <algorithm>
+#include "myc/logging/logging.h"
+
+//sum of two lengths, saturating at UINT64_MAX
+static uint64_t AddLengths(const uint64_t A, const uint64_t B)
+{
+    return A > UINT64_MAX - B ? UINT64_MAX : A + B;
+}
+
+void LS_GenerationIndex::Clear()
+{
+    for (int Character = 0; Character < 128; Character++)
+    {
+        Successors[Character] = LS_ModuleString();
+        bRewritten[Character] = false;
+    }
+    Lengths.clear();
+    Axiom = LS_ModuleString();
+    bParametric = false;
+    Generation = -1;
+}
+
+bool LS_GenerationIndex::Build(LSystem& System, const int NewGeneration)
+{
+    Clear();
+    if (NewGeneration < 0)
+    {
+        return false;
+    }
+
+    System.CompileRules();
+
+    //every rewritten character needs the one rule that is sure to apply to it
+    int Arity[128] = {0};
+    for (int Character = 0; Character < 128; Character++)
+    {
+        const std::vector<int>& Lookup = System.RuleLookup[Character];
+        if (Lookup.empty())
+        {
+            continue;
+        }
+
+        const LS_RewritingRule& Rule = System.RewritingRules[Lookup[0]];
+        if (Lookup.size() > 1 || Rule.bConditional || Rule.bContextSensitive || Rule.NumSuccessors != 1)
+        {
+            LogWarning("can't index %s, the rules for %c aren't a single deterministic, unconditional, context-free rule\n",
+                       System.Name, static_cast<char>(Character));
+            Clear();
+            return false;
+        }
+
+        //rules which failed to compile never apply, so their character is copied. Successors are copied rather than
+        //pointed to, as compiling the system's rules again rebuilds its strings in place
+        if (Rule.bCompiled)
+        {
+            Successors[Character] = Rule.Successors[0].Compiled;
+            bRewritten[Character] = true;
+            Arity[Character] = Rule.NumPredecessorParameters;
+        }
+    }
+
+    //a rule only applies to modules with as many parameters as its predecessor, which must hold for every module the
+    //system writes for lengths not to depend on parameters
+    auto HasMatchingArity = [&](const LS_ModuleString& Modules)
+    {
+        for (size_t i = 0; i < Modules.Symbols.size(); i++)
+        {
+            const auto Symbol = static_cast<unsigned char>(Modules.Symbols[i]) & 127;
+            const int NumParameters = Modules.ParameterCounts.empty() ? 0 : Modules.ParameterCounts[i];
+            if (bRewritten[Symbol] && NumParameters != Arity[Symbol])
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    bool bConsistent = HasMatchingArity(System.CompiledAxiom);
+    for (int Character = 0; Character < 128 && bConsistent; Character++)
+    {
+        bConsistent = !bRewritten[Character] || HasMatchingArity(Successors[Character]);
+    }
+    if (!bConsistent)
+    {
+        LogWarning("can't index %s, a rewritten symbol is written with a different number of parameters than its rule "
+                   "takes\n", System.Name);
+        Clear();
+        return false;
+    }
+
+    Axiom = System.CompiledAxiom;
+    bParametric = System.bParametric;
+    Generation = NewGeneration;
+
+    //every symbol is one symbol long before it's rewritten, and as long as its successor's expansion after it
+    Lengths.assign(static_cast<size_t>(Generation + 1) * 128, 1);
+    for (int Depth = 1; Depth <= Generation; Depth++)
+    {
+        for (int Character = 0; Character < 128; Character++)
+        {
+            uint64_t& Length = Lengths[static_cast<size_t>(Depth) * 128 + Character];
+            Length = bRewritten[Character]
+                     ? GetExpansionLength(Successors[Character], Depth - 1)
+                     : GetExpansionLength(static_cast<char>(Character), Depth - 1);
+        }
+    }
+
+    return true;
+}
+
+uint64_t LS_GenerationIndex::GetExpansionLength(const LS_ModuleString& Modules, const int Depth) const
+{
+    uint64_t Length = 0;
+    for (const char Symbol : Modules.Symbols)
+    {
+        Length = AddLengths(Length, GetExpansionLength(Symbol, Depth));
+    }
+    return Length;
+}
+
+void LS_GenerationIndex::LoadModule(Frame& Current, const Frame* Parent, const uint32_t Index, const uint32_t ParameterOffset) const
+{
+    Current.Index = Index;
+    Current.ParameterOffset = ParameterOffset;
+    Current.Symbol = Current.Modules->Symbols[Index];
+    Current.NumValues = Current.Modules->ParameterCounts.empty() ? 0 : Current.Modules->ParameterCounts[Index];
+    for (int i = 0; i < Current.NumValues; i++)
+    {
+        Current.Values[i] = Current.Modules->Parameters[ParameterOffset + i].Evaluate(Parent != nullptr ? Parent->Values : nullptr);
+    }
+}
+
+void LS_GenerationIndex::EnterSuccessor(Frame& Child, const Frame& Parent) const
+{
+    const auto Character = static_cast<unsigned char>(Parent.Symbol) & 127;
+    Child.Modules = bRewritten[Character] ? &Successors[Character] : nullptr;
+    if (Child.Modules != nullptr)
+    {
+        LoadModule(Child, &Parent, 0, 0);
+        return;
+    }
+
+    //copied unchanged, parameters and all
+    Child = Parent;
+    Child.Modules = nullptr;
+}
+
+bool LS_GenerationIndex::Advance(std::vector<Frame>& Path) const
+{
+    int Level = Generation;
+    while (true)
+    {
+        //the next module at this level with anything left of it by the indexed generation
+        Frame& Current = Path[Level];
+        const Frame* Parent = Level > 0 ? &Path[Level - 1] : nullptr;
+        bool bFound = false;
+        while (!bFound && Current.Modules != nullptr && Current.Index + 1 < Current.Modules->Symbols.size())
+        {
+            LoadModule(Current, Parent, Current.Index + 1, Current.ParameterOffset + Current.NumValues);
+            bFound = GetExpansionLength(Current.Symbol, Generation - Level) > 0;
+        }
+        if (!bFound)
+        {
+            if (Level == 0)
+            {
+                return false;
+            }
+            Level--;
+            continue;
+        }
+
+        //then down to the first symbol of its expansion
+        for (; Level < Generation; Level++)
+        {
+            Frame& Child = Path[Level + 1];
+            EnterSuccessor(Child, Path[Level]);
+            while (GetExpansionLength(Child.Symbol, Generation - Level - 1) == 0)
+            {
+                LoadModule(Child, &Path[Level], Child.Index + 1, Child.ParameterOffset + Child.NumValues);
+            }
+        }
+        return true;
+    }
+}
+
+size_t LS_GenerationIndex::GetSubstring(const uint64_t Start, const size_t Count, std::string& Symbols,
+                                        std::vector<unsigned char>* ParameterCounts, std::vector<float>* Parameters) const
+{
+    Symbols.clear();
+    if (ParameterCounts != nullptr)
+    {
+        ParameterCounts->clear();
+    }
+    if (Parameters != nullptr)
+    {
+        Parameters->clear();
+    }
+    if (Generation < 0 || Count == 0 || Start >= GetLength())
+    {
+        return 0;
+    }
+
+    //descend from the axiom, skipping every subtree that ends before Start
+    std::vector<Frame> Path(Generation + 1);
+    uint64_t Remaining = Start;
+    Path[0].Modules = &Axiom;
+    LoadModule(Path[0], nullptr, 0, 0);
+    for (int Level = 0; Level <= Generation; Level++)
+    {
+        Frame& Current = Path[Level];
+        const Frame* Parent = Level > 0 ? &Path[Level - 1] : nullptr;
+        for (uint64_t Length = GetExpansionLength(Current.Symbol, Generation - Level); Remaining >= Length;
+             Length = GetExpansionLength(Current.Symbol, Generation - Level))
+        {
+            Remaining -= Length;
+            LoadModule(Current, Parent, Current.Index + 1, Current.ParameterOffset + Current.NumValues);
+        }
+        if (Level < Generation)
+        {
+            EnterSuccessor(Path[Level + 1], Current);
+        }
+    }
+
+    //then walk the tree in order, one symbol at a time
+    do
+    {
+        const Frame& Leaf = Path[Generation];
+        Symbols.push_back(Leaf.Symbol);
+        if (ParameterCounts != nullptr && bParametric)
+        {
+            ParameterCounts->push_back(static_cast<unsigned char>(Leaf.NumValues));
+        }
+        if (Parameters != nullptr)
+        {
+            Parameters->insert(Parameters->end(), Leaf.Values, Leaf.Values + Leaf.NumValues);
+        }
+    }
+    while (Symbols.size() < Count && Advance(Path));
+
+    return Symbols.size();
+}
+
+char LS_GenerationIndex::GetSymbol(const uint64_t Position) const
+{
+    std::string Symbol;
+    return GetSubstring(Position, 1, Symbol) == 1 ? Symbol[0] : '\0';
+}
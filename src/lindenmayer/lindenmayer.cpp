@@ -3,15 +3,545 @@
 //
 
 #include "lindenmayer/lindenmayer.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
 #include <cstring>
 #include <cstdio>
 #include "myc/logging/logging.h"
 #include "glm/gtc/matrix_transform.hpp"
+#include "utility/Hash.h"
+#include "utility/Profiler.h"
+#include "utility/Random.h"
 
-LS_RewritingRule::LS_RewritingRule(const char c, const char *R)
+//copy Source into Destination, dropping whitespace, so equivalent predecessors and conditions compare equal
+static void CopyWithoutWhitespace(char* Destination, const char* Source, const size_t DestinationSize)
 {
-    Character = c;
-    strncat(RString, R, strnlen(R, MaxReplacementLength));
+    size_t Length = 0;
+    for (; Source != nullptr && *Source != '\0' && Length + 1 < DestinationSize; Source++)
+    {
+        if (static_cast<unsigned char>(*Source) > 32)
+        {
+            Destination[Length++] = *Source;
+        }
+    }
+    Destination[Length] = '\0';
+}
+
+/** ParseFormalNames
+ * Parses a parameter name list such as "(x,y)", advancing Cursor past it
+ * @return false if the list is malformed
+ */
+static bool ParseFormalNames(const char*& Cursor, std::vector<std::string>& Names)
+{
+    if (*Cursor != '(')
+    {
+        return true;
+    }
+    Cursor++;
+
+    const size_t FirstName = Names.size();
+
+    while (true)
+    {
+        const char* NameStart = Cursor;
+        while (isalnum(static_cast<unsigned char>(*Cursor)) || *Cursor == '_')
+        {
+            Cursor++;
+        }
+        if (Cursor == NameStart || isdigit(static_cast<unsigned char>(*NameStart)))
+        {
+            return false;
+        }
+        Names.emplace_back(NameStart, Cursor);
+
+        if (*Cursor == ')')
+        {
+            Cursor++;
+            return Names.size() - FirstName <= MaxParameters;
+        }
+        if (*Cursor != ',')
+        {
+            return false;
+        }
+        Cursor++;
+    }
+}
+
+/** ParseModulePattern
+ * Parses the modules of a rule's context up to End, such as "B(x)C", recording each symbol, its parameter count,
+ * and its parameter names
+ * @param bAllowBranches - whether the pattern may contain branches, such as "G[H]M". Only right contexts can, a
+ * left context is the path back to the root and never enters a branch
+ * @return false if the pattern is malformed
+ */
+static bool ParseModulePattern(const char*& Cursor, const char* End, std::string& Symbols,
+                               std::vector<unsigned char>& ParameterCounts, std::vector<std::string>& Names,
+                               const bool bAllowBranches)
+{
+    int Depth = 0;
+    while (Cursor < End)
+    {
+        const char Symbol = *Cursor++;
+        if (Symbol == '[' || Symbol == ']')
+        {
+            //a branch may be left open, but not closed before it was opened
+            Depth += Symbol == '[' ? 1 : -1;
+            if (!bAllowBranches || Depth < 0)
+            {
+                return false;
+            }
+            Symbols.push_back(Symbol);
+            ParameterCounts.push_back(0);
+            continue;
+        }
+
+        const size_t FirstName = Names.size();
+        if (!ParseFormalNames(Cursor, Names))
+        {
+            return false;
+        }
+        Symbols.push_back(Symbol);
+        ParameterCounts.push_back(static_cast<unsigned char>(Names.size() - FirstName));
+    }
+    return Cursor == End;
+}
+
+/** FindTopLevel
+ * Finds the first Delimiter outside of a parameter list, searching from the second character so a lone '<' or '>'
+ * is still read as a predecessor
+ * @return the delimiter, or nullptr if there isn't one
+ */
+static const char* FindTopLevel(const char* String, const char Delimiter)
+{
+    int Depth = 0;
+    for (const char* Cursor = String; *Cursor != '\0'; Cursor++)
+    {
+        if (*Cursor == '(')
+        {
+            Depth++;
+        }
+        else if (*Cursor == ')')
+        {
+            Depth--;
+        }
+        else if (*Cursor == Delimiter && Depth == 0 && Cursor != String)
+        {
+            return Cursor;
+        }
+    }
+    return nullptr;
+}
+
+void BuildBracketIndex(const char* Symbols, const size_t Length, std::vector<int>& BracketMatch)
+{
+    BracketMatch.assign(Length, -1);
+
+    //open brackets form a linked stack through BracketMatch itself, each pointing at the one enclosing it
+    int Open = -1;
+    for (size_t i = 0; i < Length; i++)
+    {
+        if (Symbols[i] == '[')
+        {
+            BracketMatch[i] = Open;
+            Open = static_cast<int>(i);
+        }
+        else if (Symbols[i] == ']' && Open >= 0)
+        {
+            const int Enclosing = BracketMatch[Open];
+            BracketMatch[Open] = static_cast<int>(i);
+            BracketMatch[i] = Open;
+            Open = Enclosing;
+        }
+    }
+
+    //unmatched '['s still hold links, clear them
+    while (Open >= 0)
+    {
+        const int Enclosing = BracketMatch[Open];
+        BracketMatch[Open] = -1;
+        Open = Enclosing;
+    }
+}
+
+/** LS_ModuleString::Compile
+ *
+ * @param Source
+ * @param ParameterNames
+ * @param Constants
+ */
+bool LS_ModuleString::Compile(const char* Source, const std::vector<std::string>& ParameterNames, const std::vector<LS_Constant>& Constants)
+{
+    Symbols.clear();
+    ParameterCounts.clear();
+    bParametric = false;
+
+    //strings are recompiled on every rewrite, so existing expressions are compiled over to reuse their storage
+    size_t NumCompiledParameters = 0;
+
+    if (Source == nullptr)
+    {
+        Parameters.clear();
+        return true;
+    }
+
+    bool bSucceeded = true;
+    const char* Cursor = Source;
+    while (*Cursor != '\0')
+    {
+        const char Symbol = *Cursor++;
+        if (static_cast<unsigned char>(Symbol) <= 32)
+        {
+            continue;
+        }
+        Symbols.push_back(Symbol);
+
+        //split the parameter list on top level commas, compiling each parameter
+        unsigned char NumParameters = 0;
+        if (*Cursor == '(')
+        {
+            bParametric = true;
+            const char* ParameterStart = ++Cursor;
+            int Depth = 0;
+            for (;; Cursor++)
+            {
+                if (*Cursor == '\0')
+                {
+                    LogError("unterminated parameter list in \"%s\"\n", Source);
+                    bSucceeded = false;
+                    break;
+                }
+                if (*Cursor == '(')
+                {
+                    Depth++;
+                }
+                else if (*Cursor == ')' && Depth > 0)
+                {
+                    Depth--;
+                }
+                else if ((*Cursor == ',' || *Cursor == ')') && Depth == 0)
+                {
+                    if (NumCompiledParameters == Parameters.size())
+                    {
+                        Parameters.emplace_back();
+                    }
+                    bSucceeded &= Parameters[NumCompiledParameters++].Compile(std::string(ParameterStart, Cursor), ParameterNames, Constants);
+                    NumParameters++;
+
+                    if (*Cursor == ')')
+                    {
+                        Cursor++;
+                        break;
+                    }
+                    ParameterStart = Cursor + 1;
+                }
+            }
+
+            if (NumParameters > MaxParameters)
+            {
+                LogError("module %c in \"%s\" has more than %d parameters\n", Symbol, Source, MaxParameters);
+                bSucceeded = false;
+            }
+        }
+        ParameterCounts.push_back(NumParameters);
+    }
+    Parameters.resize(NumCompiledParameters);
+
+    //non-parametric strings don't carry a parameter stream
+    if (!bParametric)
+    {
+        ParameterCounts.clear();
+    }
+
+    return bSucceeded;
+}
+
+LS_RewritingRule::LS_RewritingRule(const char* Predecessor, const char* Condition)
+{
+    CopyWithoutWhitespace(PredecessorString, Predecessor, MaxPredecessorLength);
+    CopyWithoutWhitespace(ConditionString, Condition, MaxReplacementLength);
+
+    //the rewritten module follows the left context, if there is one
+    const char* LeftContextEnd = FindTopLevel(PredecessorString, '<');
+    Character = LeftContextEnd != nullptr ? LeftContextEnd[1] : PredecessorString[0];
+}
+
+void LS_RewritingRule::SetSuccessor(const char* R)
+{
+    bStochastic = false;
+    NumSuccessors = 0;
+    AddSuccessor(R, 1.0f);
+}
+
+bool LS_RewritingRule::AddSuccessor(const char* R, const float Weight)
+{
+    if (NumSuccessors >= MaxSuccessors)
+    {
+        return false;
+    }
+
+    LS_Successor& Successor = Successors[NumSuccessors++];
+    Successor.Weight = Weight;
+    Successor.RString[0] = '\0';
+    strncat(Successor.RString, R, MaxReplacementLength - 1);
+
+    BuildAliasTable();
+    return true;
+}
+
+/** LS_RewritingRule::Compile
+ *
+ * @param Constants
+ */
+bool LS_RewritingRule::Compile(const std::vector<LS_Constant>& Constants)
+{
+    bCompiled = false;
+    FormalNames.clear();
+    LeftContext.clear();
+    LeftContextCounts.clear();
+    RightContext.clear();
+    RightContextCounts.clear();
+
+    //the predecessor is LEFT<MODULE>RIGHT, where both contexts are optional, and each module is a character
+    //optionally followed by its parameter names. Names are bound left to right across all three
+    const char* Cursor = PredecessorString;
+    const char* LeftContextEnd = FindTopLevel(PredecessorString, '<');
+    bool bValid = true;
+    if (LeftContextEnd != nullptr)
+    {
+        bValid &= ParseModulePattern(Cursor, LeftContextEnd, LeftContext, LeftContextCounts, FormalNames, false);
+        Cursor = LeftContextEnd + 1;
+    }
+    NumLeftContextParameters = static_cast<int>(FormalNames.size());
+
+    Character = *Cursor++;
+    bValid &= Character != '\0' && ParseFormalNames(Cursor, FormalNames);
+    NumPredecessorParameters = static_cast<int>(FormalNames.size()) - NumLeftContextParameters;
+
+    if (bValid && *Cursor == '>')
+    {
+        Cursor++;
+        const char* End = Cursor + strlen(Cursor);
+        bValid &= Cursor != End && ParseModulePattern(Cursor, End, RightContext, RightContextCounts, FormalNames, true);
+    }
+
+    if (!bValid || *Cursor != '\0' || (LeftContextEnd != nullptr && LeftContext.empty())
+        || FormalNames.size() > LS_BoundParameters::MaxBoundParameters)
+    {
+        LogError("malformed predecessor \"%s\"\n", PredecessorString);
+        return false;
+    }
+    bContextSensitive = !LeftContext.empty() || !RightContext.empty();
+
+    bConditional = ConditionString[0] != '\0';
+    if (bConditional && !Condition.Compile(ConditionString, FormalNames, Constants))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < NumSuccessors; i++)
+    {
+        if (!Successors[i].Compiled.Compile(Successors[i].RString, FormalNames, Constants))
+        {
+            return false;
+        }
+    }
+
+    BuildAliasTable();
+    bCompiled = true;
+    return true;
+}
+
+/** LS_RewritingRule::MatchContext
+ * Walks outwards from the predecessor. To the left, a module's context is its parent, so whole branches are stepped
+ * over and the start of the enclosing branch is looked through. To the right, branches are skipped and the end of
+ * the enclosing branch stops the match, unless the context itself branches: a '[' descends into the branch that
+ * follows, and a ']' skips the rest of the current branch, so "G[H]M" matches "G[HI[JK]L]M"
+ */
+bool LS_RewritingRule::MatchContext(const LS_RewriteContext& Context, const size_t Index, const float* Parameters,
+                                    LS_BoundParameters& Bound) const
+{
+    const unsigned char* Symbols = reinterpret_cast<const unsigned char*>(Context.Symbols);
+    float* BoundValue = Bound.Storage + NumLeftContextParameters;
+
+    //left context, matched right to left, filling its parameters in backwards
+    ptrdiff_t Position = static_cast<ptrdiff_t>(Index) - 1;
+    for (ptrdiff_t m = static_cast<ptrdiff_t>(LeftContext.size()) - 1; m >= 0; m--)
+    {
+        while (Position >= 0)
+        {
+            if (Symbols[Position] == ']')
+            {
+                Position = Context.BracketMatch[Position] >= 0 ? Context.BracketMatch[Position] - 1 : -1;
+            }
+            else if (Symbols[Position] == '[' || Context.IgnoredSymbols[Symbols[Position]])
+            {
+                Position--;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if (Position < 0 || Symbols[Position] != static_cast<unsigned char>(LeftContext[m]))
+        {
+            return false;
+        }
+        const int NumParameters = Context.ParameterCounts != nullptr ? Context.ParameterCounts[Position] : 0;
+        if (NumParameters != LeftContextCounts[m])
+        {
+            return false;
+        }
+
+        BoundValue -= NumParameters;
+        if (NumParameters > 0)
+        {
+            memcpy(BoundValue, Context.Parameters + Context.ParameterOffsets[Position], NumParameters * sizeof(float));
+        }
+        Position--;
+    }
+
+    //predecessor
+    BoundValue = Bound.Storage + NumLeftContextParameters;
+    if (NumPredecessorParameters > 0)
+    {
+        memcpy(BoundValue, Parameters, NumPredecessorParameters * sizeof(float));
+    }
+    BoundValue += NumPredecessorParameters;
+
+    //right context, matched left to right
+    size_t Next = Index + 1;
+    for (size_t m = 0; m < RightContext.size(); m++)
+    {
+        if (RightContext[m] == ']')
+        {
+            //step past the ']' closing the current branch, skipping whatever else it holds
+            while (Next < Context.Length && Symbols[Next] != ']')
+            {
+                Next = Symbols[Next] == '[' && Context.BracketMatch[Next] >= 0
+                           ? static_cast<size_t>(Context.BracketMatch[Next]) + 1 : Next + 1;
+            }
+            if (Next >= Context.Length)
+            {
+                return false;
+            }
+            Next++;
+            continue;
+        }
+
+        const bool bBranch = RightContext[m] == '[';
+        while (Next < Context.Length)
+        {
+            if (!bBranch && Symbols[Next] == '[' && Context.BracketMatch[Next] >= 0)
+            {
+                Next = static_cast<size_t>(Context.BracketMatch[Next]) + 1;
+            }
+            else if (Context.IgnoredSymbols[Symbols[Next]])
+            {
+                Next++;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if (Next >= Context.Length || Symbols[Next] != static_cast<unsigned char>(RightContext[m]))
+        {
+            return false;
+        }
+        const int NumParameters = Context.ParameterCounts != nullptr ? Context.ParameterCounts[Next] : 0;
+        if (NumParameters != RightContextCounts[m])
+        {
+            return false;
+        }
+
+        if (NumParameters > 0)
+        {
+            memcpy(BoundValue, Context.Parameters + Context.ParameterOffsets[Next], NumParameters * sizeof(float));
+        }
+        BoundValue += NumParameters;
+        Next++;
+    }
+
+    Bound.Values = Bound.Storage;
+    return true;
+}
+
+/** LS_RewritingRule::BuildAliasTable
+ * Builds Vose's alias table, splitting the successor weights into NumSuccessors equally likely columns which each
+ * hold at most two successors, so a selection costs one random number, a multiply, and a compare
+ */
+void LS_RewritingRule::BuildAliasTable()
+{
+    double TotalWeight = 0.0;
+    for (int i = 0; i < NumSuccessors; i++)
+    {
+        TotalWeight += Successors[i].Weight > 0.0f ? Successors[i].Weight : 0.0f;
+    }
+
+    //scale weights so the average column holds exactly 1.0, falling back to a uniform choice if all weights are 0
+    double Scaled[MaxSuccessors];
+    int Small[MaxSuccessors], Large[MaxSuccessors];
+    int NumSmall = 0, NumLarge = 0;
+    for (int i = 0; i < NumSuccessors; i++)
+    {
+        const double Weight = Successors[i].Weight > 0.0f ? Successors[i].Weight : 0.0;
+        Scaled[i] = TotalWeight > 0.0 ? Weight * NumSuccessors / TotalWeight : 1.0;
+        if (Scaled[i] < 1.0)
+        {
+            Small[NumSmall++] = i;
+        }
+        else
+        {
+            Large[NumLarge++] = i;
+        }
+    }
+
+    //pair each under-full column with an over-full one, which donates the remainder of the column
+    while (NumSmall > 0 && NumLarge > 0)
+    {
+        const int S = Small[--NumSmall];
+        const int L = Large[--NumLarge];
+        AliasThreshold[S] = static_cast<uint32_t>(Scaled[S] * 4294967296.0);
+        AliasIndex[S] = static_cast<unsigned char>(L);
+
+        Scaled[L] = (Scaled[L] + Scaled[S]) - 1.0;
+        if (Scaled[L] < 1.0)
+        {
+            Small[NumSmall++] = L;
+        }
+        else
+        {
+            Large[NumLarge++] = L;
+        }
+    }
+
+    //remaining columns are full (up to rounding error), and always keep their own successor
+    while (NumLarge > 0)
+    {
+        const int L = Large[--NumLarge];
+        AliasThreshold[L] = UINT32_MAX;
+        AliasIndex[L] = static_cast<unsigned char>(L);
+    }
+    while (NumSmall > 0)
+    {
+        const int S = Small[--NumSmall];
+        AliasThreshold[S] = UINT32_MAX;
+        AliasIndex[S] = static_cast<unsigned char>(S);
+    }
+}
+
+//until a rewrite has been timed, estimates assume the rate of the slowest, parametric, examples in a release build
+double LSystem::RewriteSymbolsPerSecond = 1.0e8;
+
+LS_PrimitiveSizes LSystem::PrimitiveSizes;
+
+void LSystem::SetPrimitiveSizes(const LS_PrimitiveSizes& Sizes)
+{
+    PrimitiveSizes = Sizes;
 }
 
 /** LSystem::LSystem
@@ -27,7 +557,8 @@ LSystem::LSystem()
 
 void LSystem::SetName(const char* NewName)
 {
-    Name = strdup(NewName);
+    Name[0] = '\0';
+    strncat(Name, NewName, MaxNameLength - 1);
 }
 
 /** LSystem::SetAxiom
@@ -36,12 +567,37 @@ void LSystem::SetName(const char* NewName)
  */
 void LSystem::SetAxiom(const char* NewAxiom)
 {
-    Axiom = strdup(NewAxiom);
+    if (strlen(NewAxiom) >= MaxReplacementLength)
+    {
+        LogWarning("axiom longer than %d characters, truncating\n", MaxReplacementLength - 1);
+    }
+    Axiom[0] = '\0';
+    strncat(Axiom, NewAxiom, MaxReplacementLength - 1);
 }
 
-void LSystem::SetIterations(int NewIterations)
+int LSystem::SetIterations(int NewIterations)
 {
     Iterations = NewIterations;
+    if (MemoryBudget == 0)
+    {
+        return Iterations;
+    }
+
+    const LS_GrowthPrediction Prediction = PredictGeneration(NewIterations);
+    if (Prediction.Log2TotalBytes > log2(static_cast<double>(MemoryBudget)))
+    {
+        Iterations = GetLargestIterationWithin(MemoryBudget, NewIterations);
+        LogWarning("iteration %d would use 2^%.1f bytes, growing %.3fx per iteration and taking %.3g seconds to "
+                   "rewrite, past the budget of %zu bytes, using %d iterations\n", NewIterations,
+                   Prediction.Log2TotalBytes, Prediction.GrowthRate, Prediction.EstimatedRewriteSeconds, MemoryBudget,
+                   Iterations);
+    }
+    return Iterations;
+}
+
+void LSystem::SetMemoryBudget(const size_t Bytes)
+{
+    MemoryBudget = Bytes;
 }
 
 /** LSystem::AddRule
@@ -51,9 +607,170 @@ void LSystem::SetIterations(int NewIterations)
  */
 void LSystem::AddRule(const char character, const char* RewrittenString)
 {
-    LS_RewritingRule& Rule = RewritingRules[static_cast<unsigned char>(character)];
-    Rule.Character = character;
-    strncat(Rule.RString, RewrittenString, strnlen(RewrittenString, MaxReplacementLength));
+    const char Predecessor[2] = {character, '\0'};
+    AddRule(Predecessor, nullptr, RewrittenString);
+}
+
+/** LSystem::AddRule
+ *
+ * @param Predecessor
+ * @param Condition
+ * @param RewrittenString
+ */
+void LSystem::AddRule(const char* Predecessor, const char* Condition, const char* RewrittenString)
+{
+    FindOrAddRule(Predecessor, Condition).SetSuccessor(RewrittenString);
+}
+
+/** LSystem::AddStochasticRule
+ *
+ * @param Predecessor
+ * @param Condition
+ * @param RewrittenString
+ * @param Weight
+ */
+void LSystem::AddStochasticRule(const char* Predecessor, const char* Condition, const char* RewrittenString, const float Weight)
+{
+    LS_RewritingRule& Rule = FindOrAddRule(Predecessor, Condition);
+
+    //a deterministic rule being given alternatives is replaced, rather than becoming one of them
+    if (!Rule.bStochastic)
+    {
+        Rule.NumSuccessors = 0;
+        Rule.bStochastic = true;
+    }
+
+    if (!Rule.AddSuccessor(RewrittenString, Weight))
+    {
+        LogWarning("rule %s already has %d alternatives, ignoring %s\n", Rule.PredecessorString, MaxSuccessors, RewrittenString);
+    }
+}
+
+bool LSystem::HasRule(const char character) const
+{
+    for (const LS_RewritingRule& Rule : RewritingRules)
+    {
+        if (Rule.Character == character)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+LS_RewritingRule* LSystem::FindRule(const char* Predecessor, const char* Condition)
+{
+    //compare against the same whitespace-free form rules store
+    const LS_RewritingRule Pattern(Predecessor, Condition);
+    for (LS_RewritingRule& Rule : RewritingRules)
+    {
+        if (strcmp(Rule.PredecessorString, Pattern.PredecessorString) == 0
+            && strcmp(Rule.ConditionString, Pattern.ConditionString) == 0)
+        {
+            return &Rule;
+        }
+    }
+    return nullptr;
+}
+
+LS_RewritingRule& LSystem::FindOrAddRule(const char* Predecessor, const char* Condition)
+{
+    LS_RewritingRule* Existing = FindRule(Predecessor, Condition);
+    if (Existing != nullptr)
+    {
+        return *Existing;
+    }
+
+    RewritingRules.emplace_back(Predecessor, Condition);
+    return RewritingRules.back();
+}
+
+void LSystem::AddConstant(const char* ConstantName, const float Value)
+{
+    for (LS_Constant& Constant : Constants)
+    {
+        if (Constant.Name == ConstantName)
+        {
+            Constant.Value = Value;
+            return;
+        }
+    }
+    Constants.push_back({ConstantName, Value});
+}
+
+void LSystem::SetIgnoredSymbols(const char* Symbols)
+{
+    IgnoredSymbolsString.clear();
+    for (bool& bIgnored : IgnoredSymbols)
+    {
+        bIgnored = false;
+    }
+
+    for (; Symbols != nullptr && *Symbols != '\0'; Symbols++)
+    {
+        const unsigned char Symbol = static_cast<unsigned char>(*Symbols);
+
+        //brackets delimit the branches contexts are matched across, they can't be skipped
+        if (Symbol <= 32 || Symbol == '[' || Symbol == ']' || IgnoredSymbols[Symbol])
+        {
+            continue;
+        }
+        IgnoredSymbols[Symbol] = true;
+        IgnoredSymbolsString.push_back(static_cast<char>(Symbol));
+    }
+}
+
+/** LSystem::CompileRules
+ *
+ */
+void LSystem::CompileRules()
+{
+    bParametric = false;
+    bContextSensitive = false;
+    for (std::vector<int>& Lookup : RuleLookup)
+    {
+        Lookup.clear();
+    }
+
+    for (size_t i = 0; i < RewritingRules.size(); i++)
+    {
+        LS_RewritingRule& Rule = RewritingRules[i];
+        if (!Rule.Compile(Constants) || static_cast<unsigned char>(Rule.Character) >= 128)
+        {
+            LogWarning("rule %s could not be compiled, ignoring it\n", Rule.PredecessorString);
+            continue;
+        }
+
+        //context-sensitive rules are more specific, so they're tried before the context-free ones
+        std::vector<int>& Lookup = RuleLookup[static_cast<unsigned char>(Rule.Character)];
+        if (Rule.bContextSensitive)
+        {
+            auto FirstContextFree = Lookup.begin();
+            while (FirstContextFree != Lookup.end() && RewritingRules[*FirstContextFree].bContextSensitive)
+            {
+                ++FirstContextFree;
+            }
+            Lookup.insert(FirstContextFree, static_cast<int>(i));
+        }
+        else
+        {
+            Lookup.push_back(static_cast<int>(i));
+        }
+
+        bContextSensitive |= Rule.bContextSensitive;
+        bParametric |= !Rule.FormalNames.empty();
+        for (int s = 0; s < Rule.NumSuccessors; s++)
+        {
+            bParametric |= Rule.Successors[s].Compiled.bParametric;
+        }
+    }
+
+    //the axiom can't reference any parameters, but can use constants
+    if (!CompiledAxiom.Compile(Axiom, {}, Constants))
+    {
+        LogWarning("axiom %s could not be compiled\n", Axiom);
+    }
+    bParametric |= CompiledAxiom.bParametric;
 }
 
 /** LSystem::Rewrite
@@ -61,98 +778,215 @@ void LSystem::AddRule(const char character, const char* RewrittenString)
  */
 void LSystem::Rewrite()
 {
-    if (Axiom == nullptr)
+    PROFILE_SCOPE("Rewrite");
+
+    //rule and axiom strings may have been edited in place, recompile them
+    CompileRules();
+
+    //start from the compiled axiom, unless continuing from a previously generated string
+    if (GeneratedString == nullptr)
     {
-        return;
+        GeneratedString = GenerationArena.AllocateArray<char>(CompiledAxiom.Symbols.size() + 1);
+        if (GeneratedString == nullptr)
+        {
+            return;
+        }
+        memcpy(GeneratedString, CompiledAxiom.Symbols.c_str(), CompiledAxiom.Symbols.size() + 1);
+        GeneratedParameterCounts = CompiledAxiom.ParameterCounts;
+        GeneratedParameters.clear();
+        for (const LS_Expression& Parameter : CompiledAxiom.Parameters)
+        {
+            GeneratedParameters.push_back(Parameter.Evaluate(nullptr));
+        }
     }
 
-    char* SourceString = GeneratedString != nullptr
-                         ? GeneratedString
-                         : Axiom;
-
-    if (SourceString == nullptr)
+    //a string generated without parameters has no parameter stream yet
+    if (bParametric && GeneratedParameterCounts.empty())
     {
-        return;
+        GeneratedParameterCounts.assign(strlen(GeneratedString), 0);
     }
 
     LogInfo("rewriting %d times...\n", Iterations);
 
-    constexpr int MaxCharacters = 1000000;
-    char WorkingBuffer[MaxCharacters] = {0};
+    //every generation is written to one working buffer, then copied into a string of its own length
+    char* WorkingBuffer = GenerationArena.AllocateArray<char>(MaxGeneratedLength);
+    if (WorkingBuffer == nullptr)
+    {
+        return;
+    }
     LogInfo("\n");
 
+    const auto StartTime = std::chrono::steady_clock::now();
+    size_t NumRewrittenCharacters = 0;
     for (int i = 0; i < Iterations; i++)
     {
-        if (GeneratedString != nullptr)
-        {
-            SourceString = GeneratedString;
-        }
+        const char* SourceString = GeneratedString;
+
+        //parameter streams advance alongside the symbols, and are skipped entirely for non-parametric systems
+        const unsigned char* SourceParameterCounts = bParametric ? GeneratedParameterCounts.data() : nullptr;
+        const float* SourceParameters = GeneratedParameters.data();
+        size_t SourceParameterOffset = 0;
+        WorkingParameterCounts.clear();
+        WorkingParameters.clear();
 
         size_t StrLength = strlen(SourceString);
         size_t NumGeneratedCharacters = 0;
-        for (int c = 0; c < StrLength; c++)
+
+        //context-sensitive rules look at a module's neighbours, which needs the bracket structure and each
+        //module's parameter offset up front
+        LS_RewriteContext Context;
+        Context.Symbols = SourceString;
+        Context.Length = StrLength;
+        Context.ParameterCounts = SourceParameterCounts;
+        Context.Parameters = SourceParameters;
+        Context.IgnoredSymbols = IgnoredSymbols;
+        if (bContextSensitive)
         {
-            char& Character = SourceString[c];
+            BuildBracketIndex(SourceString, StrLength, BracketMatch);
+            Context.BracketMatch = BracketMatch.data();
+
+            if (SourceParameterCounts != nullptr)
+            {
+                ParameterOffsets.resize(StrLength);
+                uint32_t Offset = 0;
+                for (size_t p = 0; p < StrLength; p++)
+                {
+                    ParameterOffsets[p] = Offset;
+                    Offset += SourceParameterCounts[p];
+                }
+                Context.ParameterOffsets = ParameterOffsets.data();
+            }
+        }
+        LS_BoundParameters Bound;
+        for (size_t c = 0; c < StrLength; c++)
+        {
+            const char Character = SourceString[c];
+
+            const int NumParameters = SourceParameterCounts != nullptr ? SourceParameterCounts[c] : 0;
+            const float* Parameters = SourceParameters + SourceParameterOffset;
+            SourceParameterOffset += NumParameters;
+
             if (Character < 32)
             {
                 continue;
             }
 
-            const LS_RewritingRule& Rule = RewritingRules[static_cast<unsigned char>(Character)];
-
-            const bool bUsingExplicitRule = Rule.Character == Character && Rule.RString != nullptr;
+            //the first rule for this character whose context, parameter count and condition match is applied
+            //stochastic choices are keyed on (seed, iteration, position) rather than a running generator,
+            //so the result doesn't depend on the order or thread the string is processed in
+            const LS_Successor* Successor = nullptr;
+            for (const int RuleIndex : RuleLookup[static_cast<unsigned char>(Character)])
+            {
+                const LS_RewritingRule& Rule = RewritingRules[RuleIndex];
+                if (Rule.Matches(Context, c, Parameters, NumParameters, Bound))
+                {
+                    Successor = Rule.NumSuccessors == 1
+                                ? &Rule.Successors[0]
+                                : &Rule.SelectSuccessor(CounterRandom(Seed, i, c));
+                    break;
+                }
+            }
+            const bool bUsingExplicitRule = Successor != nullptr;
 
             //if new length would exceed max characters, exit early
-            const size_t AddedLength = bUsingExplicitRule ? strlen(Rule.RString) : 1;
-            if(NumGeneratedCharacters + AddedLength >= MaxCharacters)
+            const size_t AddedLength = bUsingExplicitRule ? Successor->Compiled.Symbols.size() : 1;
+            if(NumGeneratedCharacters + AddedLength >= MaxGeneratedLength)
             {
-                LogWarning("Num generated characters exceeds 10mil limit, stopping...\n");
+                LogWarning("Num generated characters exceeds %zu limit, stopping...\n", MaxGeneratedLength);
                 break;
             }
 
 
-            //concatenate characters
+            //concatenate characters, evaluating successor parameters against those the rule bound
             if(bUsingExplicitRule)
             {
-                strcat(WorkingBuffer, Rule.RString);
+                const LS_ModuleString& Compiled = Successor->Compiled;
+                memcpy(WorkingBuffer + NumGeneratedCharacters, Compiled.Symbols.data(), AddedLength);
+
+                if (bParametric)
+                {
+                    if (Compiled.bParametric)
+                    {
+                        WorkingParameterCounts.insert(WorkingParameterCounts.end(), Compiled.ParameterCounts.begin(), Compiled.ParameterCounts.end());
+                        for (const LS_Expression& Expression : Compiled.Parameters)
+                        {
+                            WorkingParameters.push_back(Expression.Evaluate(Bound.Values));
+                        }
+                    }
+                    else
+                    {
+                        WorkingParameterCounts.insert(WorkingParameterCounts.end(), AddedLength, 0);
+                    }
+                }
             }
             else
             {
-                WorkingBuffer[NumGeneratedCharacters] = SourceString[c];
+                WorkingBuffer[NumGeneratedCharacters] = Character;
+
+                if (bParametric)
+                {
+                    WorkingParameterCounts.push_back(static_cast<unsigned char>(NumParameters));
+                    WorkingParameters.insert(WorkingParameters.end(), Parameters, Parameters + NumParameters);
+                }
             }
 
             //set new length
             NumGeneratedCharacters += AddedLength;
         }
 
-        //if the previously generated string is not null, free it
-        if (GeneratedString != nullptr)
+        //set the newly generated string to the contents of the working buffer, the previous one stays in the
+        //arena until the next reset
+        char* NewString = GenerationArena.AllocateArray<char>(NumGeneratedCharacters + 1);
+        if (NewString == nullptr)
         {
-            free(GeneratedString);
+            break;
         }
+        memcpy(NewString, WorkingBuffer, NumGeneratedCharacters);
+        NewString[NumGeneratedCharacters] = '\0';
+        GeneratedString = NewString;
 
-        //set the newly generated string to the previous contents of the working buffer
-        GeneratedString = strdup(WorkingBuffer);
-
-        //clear the working buffer
-        for (char& c : WorkingBuffer)
-        {
-            c = 0;
-        }
+        //the working parameter streams become the generated ones, and the old ones are reused next iteration
+        GeneratedParameterCounts.swap(WorkingParameterCounts);
+        GeneratedParameters.swap(WorkingParameters);
 
+        NumRewrittenCharacters += NumGeneratedCharacters;
         LogInfo("rewrite %d complete...\n", i);
     }
 
+    //rewrites too short to time reliably leave the rate as it was
+    const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+    if (Seconds > 0.001 && NumRewrittenCharacters > 0)
+    {
+        RewriteSymbolsPerSecond = static_cast<double>(NumRewrittenCharacters) / Seconds;
+    }
+
     LogInfo("Rewriting complete\n");
 }
 
 void LSystem::Reset()
 {
-    if(GeneratedString != nullptr)
-    {
-        free(GeneratedString);
-        GeneratedString = nullptr;
-    }
+    GeneratedString = nullptr;
+    GenerationArena.Reset();
+
+    GeneratedParameterCounts.clear();
+    GeneratedParameters.clear();
+}
+
+const char* LSystem::GetOutputString() const
+{
+    return GeneratedString != nullptr ? GeneratedString : Axiom;
+}
+
+const unsigned char* LSystem::GetOutputParameterCounts() const
+{
+    return GeneratedString != nullptr && bParametric && !GeneratedParameterCounts.empty()
+           ? GeneratedParameterCounts.data()
+           : nullptr;
+}
+
+const float* LSystem::GetOutputParameters() const
+{
+    return GeneratedParameters.data();
 }
 
 void LSystem::SetAngle(float NewAngle)
@@ -165,6 +999,21 @@ void LSystem::SetDistance(float NewDistance)
     Distance = NewDistance;
 }
 
+void LSystem::SetSeed(uint32_t NewSeed)
+{
+    Seed = NewSeed;
+}
+
+//strip trailing newlines and whitespace read in by fgets
+static void TrimLineEnding(char* Line)
+{
+    size_t Length = strlen(Line);
+    while (Length > 0 && static_cast<unsigned char>(Line[Length - 1]) <= 32)
+    {
+        Line[--Length] = '\0';
+    }
+}
+
 /** LSystem::LoadFromFile
  *
  * @param Filename
@@ -187,15 +1036,37 @@ void LSystem::LoadFromFile(const char* Filename)
 
     while (fgets(line, 1024, fp))
     {
+        TrimLineEnding(line);
+
         const char* AxiomString = "axiom:";
         const char* AngleString = "angle:";
         const char* IterationsString = "iterations:";
+        const char* SeedString = "seed:";
+        const char* DefineString = "define:";
+        const char* IgnoreString = "ignore:";
 
         const char* axiomStart = strstr(line, AxiomString);
         const char* angleStart = strstr(line, AngleString);
         const char* iterationsStart = strstr(line, IterationsString);
+        const char* seedStart = strstr(line, SeedString);
+        const char* defineStart = strstr(line, DefineString);
+        const char* ignoreStart = strstr(line, IgnoreString);
 
-        if (axiomStart != nullptr)
+        if (defineStart != nullptr)
+        {
+            //define:NAME=VALUE
+            char ConstantName[64] = {0};
+            float Value = 0.0f;
+            if (sscanf(defineStart + strlen(DefineString), " %63[A-Za-z0-9_] = %f", ConstantName, &Value) == 2)
+            {
+                AddConstant(ConstantName, Value);
+            }
+        }
+        else if (ignoreStart != nullptr)
+        {
+            SetIgnoredSymbols(ignoreStart + strlen(IgnoreString));
+        }
+        else if (axiomStart != nullptr)
         {
             SetAxiom(axiomStart + strlen(AxiomString));
         }
@@ -207,13 +1078,20 @@ void LSystem::LoadFromFile(const char* Filename)
         {
             Iterations = strtol(iterationsStart + strlen(IterationsString), nullptr, 10);
         }
-        else if (line[0] > 32 && line[1] == ':')
+        else if (seedStart != nullptr)
+        {
+            Seed = static_cast<uint32_t>(strtoul(seedStart + strlen(SeedString), nullptr, 10));
+        }
+        else if (line[0] > 32 && (line[1] == ':' || strstr(line, "->") != nullptr))
         {
-            AddRule(line[0], line + 2);
+            AddRuleFromString(line);
         }
     }
 
     fclose(fp);
+
+    //iterations are checked against the budget once every rule is known
+    SetIterations(Iterations);
 }
 
 void LSystem::AddRuleFromString(const char* String)
@@ -222,15 +1100,72 @@ void LSystem::AddRuleFromString(const char* String)
     {
         return;
     }
-    const int ColonOffset = static_cast<int>(strstr(String, ":") - String);
-    if(ColonOffset < 0)
+
+    //skip leading whitespace, the first character is the one being rewritten
+    while (*String == ' ' || *String == '\t')
+    {
+        String++;
+    }
+
+    //deterministic rule, C:RWRULE, unless there's an arrow, which makes the ':' the start of a condition
+    const char* ArrowStart = strstr(String, "->");
+    if (ArrowStart == nullptr && String[0] != '\0' && String[1] == ':')
+    {
+        const char* Replacement = String + 2;
+        while (*Replacement == ' ')
+        {
+            Replacement++;
+        }
+        AddRule(String[0], Replacement);
+        return;
+    }
+
+    //general rule, PRED[:COND][-(W)]->RWRULE
+    if (ArrowStart == nullptr)
     {
+        LogWarning("could not parse rule %s\n", String);
         return;
     }
 
-    char* FullString = strdup(String);
-    FullString[ColonOffset] = '\0';
-    AddRule(*FullString, FullString+ColonOffset+1);
+    //a stochastic weight is a parenthesized number directly before the arrow, following a '-'
+    const char* LeftEnd = ArrowStart;
+    bool bStochastic = false;
+    float Weight = 1.0f;
+    if (LeftEnd - String > 1 && LeftEnd[-1] == ')')
+    {
+        const char* WeightStart = LeftEnd - 1;
+        while (WeightStart > String && *WeightStart != '(')
+        {
+            WeightStart--;
+        }
+        if (WeightStart - String > 1 && WeightStart[-1] == '-')
+        {
+            bStochastic = true;
+            Weight = strtof(WeightStart + 1, nullptr);
+            LeftEnd = WeightStart - 1;
+        }
+    }
+
+    //the predecessor is separated from the condition by the first ':'
+    const std::string Left(String, LeftEnd);
+    const size_t ColonOffset = Left.find(':');
+    const std::string Predecessor = Left.substr(0, ColonOffset);
+    const std::string Condition = ColonOffset != std::string::npos ? Left.substr(ColonOffset + 1) : std::string();
+
+    const char* Replacement = ArrowStart + 2;
+    while (*Replacement == ' ')
+    {
+        Replacement++;
+    }
+
+    if (bStochastic)
+    {
+        AddStochasticRule(Predecessor.c_str(), Condition.c_str(), Replacement, Weight);
+    }
+    else
+    {
+        AddRule(Predecessor.c_str(), Condition.c_str(), Replacement);
+    }
 }
 
 void LSystem::SaveToFile(const char* Filename)
@@ -250,16 +1185,10 @@ void LSystem::SaveToFile(const char* Filename)
     }
 
     //write name
-    if(Name != nullptr)
-    {
-        fprintf(fp, "name:%s\n", Name);
-    }
+    fprintf(fp, "name:%s\n", Name);
 
     //write axiom
-    if(Axiom != nullptr)
-    {
-        fprintf(fp, "axiom:%s\n", Axiom);
-    }
+    fprintf(fp, "axiom:%s\n", Axiom);
 
     //write angle
     fprintf(fp, "angle:%f\n", Angle);
@@ -267,15 +1196,611 @@ void LSystem::SaveToFile(const char* Filename)
     //write iterations
     fprintf(fp, "iterations:%d\n", Iterations);
 
-    //write rules
-    for(LS_RewritingRule& Rule : RewritingRules)
+    //write seed
+    fprintf(fp, "seed:%u\n", Seed);
+
+    //write constants
+    for(const LS_Constant& Constant : Constants)
+    {
+        fprintf(fp, "define:%s=%f\n", Constant.Name.c_str(), Constant.Value);
+    }
+
+    //write symbols ignored by context matching
+    if(!IgnoredSymbolsString.empty())
+    {
+        fprintf(fp, "ignore:%s\n", IgnoredSymbolsString.c_str());
+    }
+
+    //write rules, stochastic rules write one line per alternative
+    for(const LS_RewritingRule& Rule : RewritingRules)
     {
-        if(Rule.Character != ' ')
+        const bool bSimpleRule = !Rule.bStochastic && Rule.ConditionString[0] == '\0' && Rule.PredecessorString[1] == '\0';
+        if(bSimpleRule)
         {
-            fprintf(fp, "%c:%s\n", Rule.Character, Rule.RString);
+            fprintf(fp, "%c:%s\n", Rule.Character, Rule.Successors[0].RString);
+            continue;
+        }
+
+        for(int i = 0; i < Rule.NumSuccessors; i++)
+        {
+            fprintf(fp, "%s", Rule.PredecessorString);
+            if(Rule.ConditionString[0] != '\0')
+            {
+                fprintf(fp, ":%s", Rule.ConditionString);
+            }
+            if(Rule.bStochastic)
+            {
+                fprintf(fp, "-(%f)", Rule.Successors[i].Weight);
+            }
+            fprintf(fp, "->%s\n", Rule.Successors[i].RString);
         }
     }
 
     fclose(fp);
 }
 
+uint64_t LSystem::GetContentHash() const
+{
+    //every field SaveToFile writes besides the name, plus the distance, which changes the drawing but isn't saved
+    uint64_t Hash = HashString(Axiom);
+    Hash = HashFloat(Angle, Hash);
+    Hash = HashValue(Iterations, Hash);
+    Hash = HashFloat(Distance, Hash);
+    Hash = HashValue(Seed, Hash);
+
+    Hash = HashValue(Constants.size(), Hash);
+    for(const LS_Constant& Constant : Constants)
+    {
+        Hash = HashString(Constant.Name.c_str(), Hash);
+        Hash = HashFloat(Constant.Value, Hash);
+    }
+
+    Hash = HashString(IgnoredSymbolsString.c_str(), Hash);
+
+    //rules are hashed in order, as the first matching rule is the one applied
+    Hash = HashValue(RewritingRules.size(), Hash);
+    for(const LS_RewritingRule& Rule : RewritingRules)
+    {
+        Hash = HashString(Rule.PredecessorString, Hash);
+        Hash = HashString(Rule.ConditionString, Hash);
+        Hash = HashValue(Rule.bStochastic, Hash);
+        Hash = HashValue(Rule.NumSuccessors, Hash);
+        for(int i = 0; i < Rule.NumSuccessors; i++)
+        {
+            Hash = HashString(Rule.Successors[i].RString, Hash);
+            Hash = HashFloat(Rule.Successors[i].Weight, Hash);
+        }
+    }
+
+    return Hash;
+}
+
+/* PredictedProduction
+ * What the successor of a character writes when predicting generations, its alternatives weighted by how often
+ * they're chosen. Characters without a rule write themselves
+ */
+struct PredictedProduction
+{
+    bool bRewritten = false;
+    double Weights[MaxSuccessors] = {0};
+    const LS_RewritingRule* Rule = nullptr;
+};
+
+/** ChoosePredictedProductions
+ * Picks the rule each character is predicted with, its first unconditional, context-free rule, or its first rule if
+ * it has none
+ * @return whether predictions are exact, every rewritten character having one deterministic rule that always applies
+ */
+static bool ChoosePredictedProductions(const std::vector<int>* RuleLookup, const std::vector<LS_RewritingRule>& Rules,
+                                       PredictedProduction* Productions)
+{
+    bool bExact = true;
+    for (int Character = 0; Character < 128; Character++)
+    {
+        const std::vector<int>& Lookup = RuleLookup[Character];
+        if (Lookup.empty())
+        {
+            continue;
+        }
+
+        const LS_RewritingRule* Chosen = nullptr;
+        for (const int RuleIndex : Lookup)
+        {
+            const LS_RewritingRule& Rule = Rules[RuleIndex];
+            if (!Rule.bContextSensitive && !Rule.bConditional)
+            {
+                Chosen = &Rule;
+                break;
+            }
+        }
+        bExact &= Lookup.size() == 1 && Chosen != nullptr;
+        Chosen = Chosen != nullptr ? Chosen : &Rules[Lookup[0]];
+        bExact &= Chosen->NumSuccessors == 1;
+
+        PredictedProduction& Rewrite = Productions[Character];
+        Rewrite.bRewritten = true;
+        Rewrite.Rule = Chosen;
+        double TotalWeight = 0.0;
+        for (int i = 0; i < Chosen->NumSuccessors; i++)
+        {
+            TotalWeight += Chosen->Successors[i].Weight;
+        }
+        for (int i = 0; i < Chosen->NumSuccessors; i++)
+        {
+            Rewrite.Weights[i] = TotalWeight > 0.0 ? Chosen->Successors[i].Weight / TotalWeight : 1.0 / Chosen->NumSuccessors;
+        }
+    }
+    return bExact;
+}
+
+/** AverageParameters
+ * Parameters per module of each symbol, from the modules written by the axiom and successors. A symbol's arity
+ * doesn't change when it's copied, so this is enough to count the parameter stream
+ */
+static void AverageParameters(const LS_ModuleString& Axiom, const std::vector<LS_RewritingRule>& Rules,
+                              double* ParametersPerModule)
+{
+    double ParameterTotals[128] = {0};
+    double ParameterModules[128] = {0};
+    auto CountParameters = [&](const LS_ModuleString& Modules)
+    {
+        for (size_t i = 0; i < Modules.ParameterCounts.size() && i < Modules.Symbols.size(); i++)
+        {
+            const auto Symbol = static_cast<unsigned char>(Modules.Symbols[i]) & 127;
+            ParameterTotals[Symbol] += Modules.ParameterCounts[i];
+            ParameterModules[Symbol] += 1.0;
+        }
+    };
+    CountParameters(Axiom);
+    for (const LS_RewritingRule& Rule : Rules)
+    {
+        for (int i = 0; i < Rule.NumSuccessors; i++)
+        {
+            CountParameters(Rule.Successors[i].Compiled);
+        }
+    }
+
+    for (int Symbol = 0; Symbol < 128; Symbol++)
+    {
+        ParametersPerModule[Symbol] = ParameterModules[Symbol] > 0.0 ? ParameterTotals[Symbol] / ParameterModules[Symbol] : 0.0;
+    }
+}
+
+/** EstimateBytes
+ * Fills in the memory of a prediction from its length, segments and triangles
+ * @param Sizes - sizes of what each primitive is drawn and uploaded as
+ * @param NumParameters - parameters carried by the string
+ * @param PolygonTriangles - triangles of polygons, which are uploaded once
+ * @param bParametric - whether the string carries a parameter stream
+ */
+static void EstimateBytes(LS_GenerationStats& Prediction, const LS_PrimitiveSizes& Sizes, const double NumParameters,
+                          const double PolygonTriangles, const bool bParametric)
+{
+    Prediction.StringBytes = Prediction.Length;
+    if (bParametric)
+    {
+        Prediction.StringBytes += Prediction.Length + NumParameters * sizeof(float);
+    }
+    Prediction.GeometryBytes = Prediction.NumTriangles * Sizes.TriangleBytes + Prediction.NumSegments * Sizes.SegmentBytes;
+    const double NumVertices = (Prediction.NumSegments * Sizes.UploadedTrianglesPerSegment + PolygonTriangles) * 3.0;
+    Prediction.VertexBytes = NumVertices * Sizes.VertexBytes * Sizes.VertexBufferOverhead;
+}
+
+void LSystem::PredictGenerations(const int NumGenerations, std::vector<LS_GenerationStats>& Stats)
+{
+    Stats.clear();
+    if (NumGenerations < 0)
+    {
+        return;
+    }
+
+    //predictions read the compiled successors, so edits made in place are picked up as they are by Rewrite
+    CompileRules();
+
+    PredictedProduction Productions[128];
+    const bool bExact = ChoosePredictedProductions(RuleLookup, RewritingRules, Productions);
+    double ParametersPerModule[128];
+    AverageParameters(CompiledAxiom, RewritingRules, ParametersPerModule);
+
+    //bracket depth of a symbol's expansion after some generations, as the net depth it leaves behind and the deepest
+    //it reaches on the way, advanced alongside the counts
+    long long NetDepth[128] = {0};
+    long long MaxDepth[128] = {0};
+    NetDepth['['] = 1;
+    MaxDepth['['] = 1;
+    NetDepth[']'] = -1;
+
+    //vertices recorded by a symbol's expansion, in all and only those within a polygon the expansion opens itself,
+    //so the vertices of polygons can be told apart from those of moves outside any polygon
+    double AllVertices[128] = {0};
+    double PolygonVertices[128] = {0};
+    AllVertices['F'] = 1.0;
+    AllVertices['f'] = 1.0;
+    AllVertices['.'] = 1.0;
+
+    //vertices recorded within polygons by a string, given the expansions of its symbols
+    auto CountPolygonVertices = [](const std::string& Symbols, const double* All, const double* Polygon)
+    {
+        double Vertices = 0.0;
+        int PolygonDepth = 0;
+        for (const char Symbol : Symbols)
+        {
+            const auto Index = static_cast<unsigned char>(Symbol) & 127;
+            PolygonDepth += Symbol == '{' ? 1 : Symbol == '}' ? -1 : 0;
+            Vertices += PolygonDepth > 0 ? All[Index] : Polygon[Index];
+        }
+        return Vertices;
+    };
+
+    double Counts[128] = {0};
+    for (const char Symbol : CompiledAxiom.Symbols)
+    {
+        Counts[static_cast<unsigned char>(Symbol) & 127] += 1.0;
+    }
+
+    for (int Generation = 0; Generation <= NumGenerations; Generation++)
+    {
+        LS_GenerationStats Prediction;
+        Prediction.Iteration = Generation;
+        Prediction.bExact = bExact;
+
+        double NumParameters = 0.0;
+        for (int Symbol = 0; Symbol < 128; Symbol++)
+        {
+            Prediction.SymbolCounts[Symbol] = Counts[Symbol];
+            Prediction.Length += Counts[Symbol];
+            NumParameters += Counts[Symbol] * ParametersPerModule[Symbol];
+        }
+
+        long long Depth = 0;
+        for (const char Symbol : CompiledAxiom.Symbols)
+        {
+            const auto Index = static_cast<unsigned char>(Symbol) & 127;
+            Prediction.MaxBracketDepth = std::max(Prediction.MaxBracketDepth, Depth + MaxDepth[Index]);
+            Depth += NetDepth[Index];
+        }
+
+        //a polygon records a vertex where it starts, and n vertices are triangulated into at most n - 2 triangles,
+        //fewer when vertices coincide
+        Prediction.NumSegments = Counts['F'] + Counts['G'];
+        const double NumPolygonVertices = CountPolygonVertices(CompiledAxiom.Symbols, AllVertices, PolygonVertices) + Counts['{'];
+        const double PolygonTriangles = std::max(0.0, NumPolygonVertices - 2.0 * Counts['}']);
+        Prediction.NumTriangles = Prediction.NumSegments * PrimitiveSizes.TrianglesPerSegment + PolygonTriangles;
+
+        EstimateBytes(Prediction, PrimitiveSizes, NumParameters, PolygonTriangles, bParametric);
+        Prediction.StringBytes += 1.0;
+        Prediction.bTruncated = Prediction.Length >= static_cast<double>(MaxGeneratedLength) || Prediction.NumTriangles > PrimitiveSizes.MaxTriangles;
+        Stats.push_back(Prediction);
+
+        if (Generation == NumGenerations)
+        {
+            break;
+        }
+
+        //advance the counts and depths by one generation
+        double NextCounts[128] = {0};
+        double NextAllVertices[128] = {0};
+        double NextPolygonVertices[128] = {0};
+        long long NextNetDepth[128];
+        long long NextMaxDepth[128];
+        for (int Character = 0; Character < 128; Character++)
+        {
+            const PredictedProduction& Rewrite = Productions[Character];
+            NextNetDepth[Character] = NetDepth[Character];
+            NextMaxDepth[Character] = MaxDepth[Character];
+            NextAllVertices[Character] = AllVertices[Character];
+            NextPolygonVertices[Character] = PolygonVertices[Character];
+            if (!Rewrite.bRewritten)
+            {
+                NextCounts[Character] += Counts[Character];
+                continue;
+            }
+
+            NextNetDepth[Character] = 0;
+            NextMaxDepth[Character] = 0;
+            NextAllVertices[Character] = 0.0;
+            NextPolygonVertices[Character] = 0.0;
+            for (int i = 0; i < Rewrite.Rule->NumSuccessors; i++)
+            {
+                const std::string& Successor = Rewrite.Rule->Successors[i].Compiled.Symbols;
+                NextPolygonVertices[Character] += Rewrite.Weights[i] * CountPolygonVertices(Successor, AllVertices, PolygonVertices);
+
+                long long Running = 0;
+                long long Deepest = 0;
+                for (const char Symbol : Successor)
+                {
+                    const auto Index = static_cast<unsigned char>(Symbol) & 127;
+                    NextCounts[Index] += Counts[Character] * Rewrite.Weights[i];
+                    NextAllVertices[Character] += Rewrite.Weights[i] * AllVertices[Index];
+                    Deepest = std::max(Deepest, Running + MaxDepth[Index]);
+                    Running += NetDepth[Index];
+                }
+                NextNetDepth[Character] = i == 0 ? Running : std::max(NextNetDepth[Character], Running);
+                NextMaxDepth[Character] = std::max(NextMaxDepth[Character], Deepest);
+            }
+        }
+        memcpy(Counts, NextCounts, sizeof(Counts));
+        memcpy(NetDepth, NextNetDepth, sizeof(NetDepth));
+        memcpy(MaxDepth, NextMaxDepth, sizeof(MaxDepth));
+        memcpy(AllVertices, NextAllVertices, sizeof(AllVertices));
+        memcpy(PolygonVertices, NextPolygonVertices, sizeof(PolygonVertices));
+    }
+}
+
+/* ScaledMatrix
+ * Square matrix of Entries * 2^Exponent. Entries are rescaled by powers of two, which is exact, whenever they grow
+ * large, so integer counts stay exact while they fit in a double's mantissa and are kept to its precision past that
+ * rather than overflowing
+ */
+struct ScaledMatrix
+{
+    int Size = 0;
+    std::vector<double> Entries;
+    long long Exponent = 0;
+
+    explicit ScaledMatrix(const int NewSize, const bool bIdentity = false) : Size(NewSize), Entries(static_cast<size_t>(NewSize) * NewSize, 0.0)
+    {
+        for (int i = 0; bIdentity && i < Size; i++)
+        {
+            At(i, i) = 1.0;
+        }
+    }
+
+    double& At(const int Row, const int Column) { return Entries[static_cast<size_t>(Row) * Size + Column]; }
+    double At(const int Row, const int Column) const { return Entries[static_cast<size_t>(Row) * Size + Column]; }
+
+    ScaledMatrix operator*(const ScaledMatrix& Other) const
+    {
+        ScaledMatrix Product(Size);
+        Product.Exponent = Exponent + Other.Exponent;
+        for (int Row = 0; Row < Size; Row++)
+        {
+            for (int Inner = 0; Inner < Size; Inner++)
+            {
+                const double Left = At(Row, Inner);
+                if (Left == 0.0)
+                {
+                    continue;
+                }
+                for (int Column = 0; Column < Size; Column++)
+                {
+                    Product.At(Row, Column) += Left * Other.At(Inner, Column);
+                }
+            }
+        }
+        Product.Rescale();
+        return Product;
+    }
+
+    //moves a power of two between the entries and the exponent once they pass 2^256, or fall below 2^-256, so
+    //multiplying them can neither overflow nor underflow
+    void Rescale()
+    {
+        const double Largest = *std::max_element(Entries.begin(), Entries.end());
+        if (Largest == 0.0 || (Largest < 0x1p256 && Largest > 0x1p-256))
+        {
+            return;
+        }
+        int Shift = 0;
+        frexp(Largest, &Shift);
+        for (double& Entry : Entries)
+        {
+            Entry = ldexp(Entry, -Shift);
+        }
+        Exponent += Shift;
+    }
+};
+
+LS_GrowthPrediction LSystem::PredictGeneration(const int Iteration)
+{
+    CompileRules();
+
+    PredictedProduction Productions[128];
+    double ParametersPerModule[128];
+    LS_GrowthPrediction Prediction;
+    Prediction.Iteration = std::max(Iteration, 0);
+    Prediction.bExact = ChoosePredictedProductions(RuleLookup, RewritingRules, Productions);
+    AverageParameters(CompiledAxiom, RewritingRules, ParametersPerModule);
+
+    //the alphabet is every symbol reachable from the axiom, numbered in the order it's found
+    int Slots[128];
+    std::fill(Slots, Slots + 128, -1);
+    std::vector<int> Alphabet;
+    auto AddSymbols = [&](const std::string& Symbols)
+    {
+        for (const char Symbol : Symbols)
+        {
+            const auto Index = static_cast<unsigned char>(Symbol) & 127;
+            if (Slots[Index] < 0)
+            {
+                Slots[Index] = static_cast<int>(Alphabet.size());
+                Alphabet.push_back(Index);
+            }
+        }
+    };
+    AddSymbols(CompiledAxiom.Symbols);
+    for (size_t i = 0; i < Alphabet.size(); i++)
+    {
+        const PredictedProduction& Rewrite = Productions[Alphabet[i]];
+        for (int j = 0; Rewrite.bRewritten && j < Rewrite.Rule->NumSuccessors; j++)
+        {
+            AddSymbols(Rewrite.Rule->Successors[j].Compiled.Symbols);
+        }
+    }
+
+    //every symbol has a slot for its copies within polygons and one for those outside, so the vertices of polygons
+    //can be counted, and a last slot accumulates the symbols written by every generation so far. Column c of the
+    //transition holds what one symbol of slot c becomes in the next generation
+    const int NumSymbols = static_cast<int>(Alphabet.size());
+    const int Accumulated = NumSymbols * 2;
+    auto Inside = [&](const int Symbol) { return Slots[Symbol]; };
+    auto Outside = [&](const int Symbol) { return NumSymbols + Slots[Symbol]; };
+
+    //adds the symbols of a string to Column, with those within the string's own polygons, or all of them if the
+    //string is already within a polygon, inside
+    ScaledMatrix Transition(Accumulated + 1);
+    auto AddString = [&](const std::string& Symbols, const double Weight, const bool bWithinPolygon, double* Vector, const int Column)
+    {
+        int PolygonDepth = 0;
+        for (const char Symbol : Symbols)
+        {
+            const auto Index = static_cast<unsigned char>(Symbol) & 127;
+            PolygonDepth += Symbol == '{' ? 1 : Symbol == '}' ? -1 : 0;
+            const int Row = bWithinPolygon || PolygonDepth > 0 ? Inside(Index) : Outside(Index);
+            if (Vector != nullptr)
+            {
+                Vector[Row] += Weight;
+            }
+            else
+            {
+                Transition.At(Row, Column) += Weight;
+                Transition.At(Accumulated, Column) += Weight;
+            }
+        }
+    };
+    for (const int Symbol : Alphabet)
+    {
+        const PredictedProduction& Rewrite = Productions[Symbol];
+        if (!Rewrite.bRewritten)
+        {
+            Transition.At(Inside(Symbol), Inside(Symbol)) = 1.0;
+            Transition.At(Outside(Symbol), Outside(Symbol)) = 1.0;
+            Transition.At(Accumulated, Inside(Symbol)) = 1.0;
+            Transition.At(Accumulated, Outside(Symbol)) = 1.0;
+            continue;
+        }
+        for (int i = 0; i < Rewrite.Rule->NumSuccessors; i++)
+        {
+            const std::string& Successor = Rewrite.Rule->Successors[i].Compiled.Symbols;
+            AddString(Successor, Rewrite.Weights[i], true, nullptr, Inside(Symbol));
+            AddString(Successor, Rewrite.Weights[i], false, nullptr, Outside(Symbol));
+        }
+    }
+    Transition.At(Accumulated, Accumulated) = 1.0;
+
+    //growth in the long run is the production matrix's largest eigenvalue, found by power iteration. Iterating with
+    //M + I rather than M converges for periodic systems too, and leaves the eigenvalue shifted by one
+    std::vector<double> Eigenvector(NumSymbols, 1.0 / std::max(NumSymbols, 1));
+    std::vector<double> NextEigenvector(NumSymbols);
+    for (int Step = 0; Step < 1000 && NumSymbols > 0; Step++)
+    {
+        double Total = 0.0;
+        for (int Row = 0; Row < NumSymbols; Row++)
+        {
+            double Sum = Eigenvector[Row];
+            for (int Column = 0; Column < NumSymbols; Column++)
+            {
+                Sum += (Transition.At(NumSymbols + Row, NumSymbols + Column) + Transition.At(Row, NumSymbols + Column)) * Eigenvector[Column];
+            }
+            NextEigenvector[Row] = Sum;
+            Total += Sum;
+        }
+        const double PreviousRate = Prediction.GrowthRate;
+        Prediction.GrowthRate = Total - 1.0;
+        for (int Row = 0; Row < NumSymbols; Row++)
+        {
+            Eigenvector[Row] = NextEigenvector[Row] / Total;
+        }
+        if (Step > 0 && fabs(Prediction.GrowthRate - PreviousRate) <= 1e-12 * Total)
+        {
+            break;
+        }
+    }
+
+    //the axiom's symbols, raised through the generations by repeated squaring
+    ScaledMatrix Power(Accumulated + 1, true);
+    ScaledMatrix Square = Transition;
+    for (int Remaining = Prediction.Iteration; Remaining > 0; Remaining >>= 1)
+    {
+        if (Remaining & 1)
+        {
+            Power = Power * Square;
+        }
+        if (Remaining > 1)
+        {
+            Square = Square * Square;
+        }
+    }
+    std::vector<double> Axiom(Accumulated + 1, 0.0);
+    AddString(CompiledAxiom.Symbols, 1.0, false, Axiom.data(), 0);
+    std::vector<double> State(Accumulated + 1, 0.0);
+    for (int Row = 0; Row <= Accumulated; Row++)
+    {
+        for (int Column = 0; Column <= Accumulated; Column++)
+        {
+            State[Row] += Power.At(Row, Column) * Axiom[Column];
+        }
+    }
+
+    //sizes are worked out on the scaled counts, then moved to the log domain with the scale's exponent
+    const auto Scale = static_cast<double>(Power.Exponent);
+    auto Log2 = [Scale](const double Value) { return Value > 0.0 ? log2(Value) + Scale : -INFINITY; };
+    double Counts[128] = {0};
+    double NumParameters = 0.0;
+    LS_GenerationStats Scaled;
+    for (const int Symbol : Alphabet)
+    {
+        Counts[Symbol] = State[Inside(Symbol)] + State[Outside(Symbol)];
+        Scaled.Length += Counts[Symbol];
+        NumParameters += Counts[Symbol] * ParametersPerModule[Symbol];
+    }
+    for (int Symbol = 0; Symbol < 128; Symbol++)
+    {
+        Prediction.Log2SymbolCounts[Symbol] = Log2(Counts[Symbol]);
+    }
+
+    //as in PredictGenerations, polygons record a vertex where they start, and are triangulated into n - 2 triangles
+    double PolygonVertices = Counts['{'];
+    for (const int Symbol : {'F', 'f', '.'})
+    {
+        PolygonVertices += Slots[Symbol] >= 0 ? State[Inside(Symbol)] : 0.0;
+    }
+    const double PolygonTriangles = std::max(0.0, PolygonVertices - 2.0 * Counts['}']);
+    Scaled.NumSegments = Counts['F'] + Counts['G'];
+    Scaled.NumTriangles = Scaled.NumSegments * PrimitiveSizes.TrianglesPerSegment + PolygonTriangles;
+    EstimateBytes(Scaled, PrimitiveSizes, NumParameters, PolygonTriangles, bParametric);
+
+    Prediction.Log2Length = Log2(Scaled.Length);
+    Prediction.Log2NumSegments = Log2(Scaled.NumSegments);
+    Prediction.Log2NumTriangles = Log2(Scaled.NumTriangles);
+    Prediction.Log2TotalBytes = Log2(Scaled.GetTotalBytes() + ldexp(1.0, -Power.Exponent));
+    Prediction.Log2RewrittenSymbols = Log2(State[Accumulated]);
+    Prediction.EstimatedRewriteSeconds = exp2(Prediction.Log2RewrittenSymbols) / RewriteSymbolsPerSecond;
+    Prediction.bTruncated = Prediction.Log2Length >= log2(static_cast<double>(MaxGeneratedLength)) ||
+                            Prediction.Log2NumTriangles > log2(PrimitiveSizes.MaxTriangles);
+    return Prediction;
+}
+
+int LSystem::GetLargestIterationWithin(const size_t Bytes, const int MaxIteration)
+{
+    //generations don't only grow, erasing rules, signals and conditions can shrink them again, so the iterations
+    //below MaxIteration are tried one by one, largest first, and each costs one fast-forwarded prediction
+    const double Log2Bytes = log2(static_cast<double>(Bytes));
+    const int Highest = std::max(MaxIteration, 0);
+    const int LowestScanned = std::max(Highest - MaxScannedIterations + 1, 0);
+    for (int Iteration = Highest; Iteration >= LowestScanned; Iteration--)
+    {
+        if (PredictGeneration(Iteration).Log2TotalBytes <= Log2Bytes)
+        {
+            return Iteration;
+        }
+    }
+
+    //below the scanned iterations generations are taken to grow, so the largest that fits is found by bisection.
+    //Where they don't, this is only a lower bound on the largest that fits
+    int Lowest = 0;
+    int Upper = LowestScanned - 1;
+    while (Lowest < Upper)
+    {
+        const int Middle = Lowest + (Upper - Lowest + 1) / 2;
+        if (PredictGeneration(Middle).Log2TotalBytes <= Log2Bytes)
+        {
+            Lowest = Middle;
+        }
+        else
+        {
+            Upper = Middle - 1;
+        }
+    }
+    return Lowest;
+}
@@ -5,11 +5,15 @@
 #include "main.h"
 
 //std
+#include <cctype>
+#include <cmath>
 #include <cstring>
 
 //utility
 #include "myc/logging/logging.h"
+#include "myc/paths/paths.h"
 #include "utility/util.h"
+#include "utility/Profiler.h"
 
 //imgui
 #include "../lib/imgui/imgui.h"
@@ -20,6 +24,7 @@
 #include "rendering/ShaderProgram.h"
 #include "rendering/ShaderObject.h"
 #include "rendering/ShaderManager.h"
+#include "rendering/SurfaceLibrary.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -27,6 +32,9 @@
 Rendering::ShaderManager* shaderManager;
 std::shared_ptr<Rendering::ShaderProgram> PassthroughShaderProgram;
 std::shared_ptr<Rendering::ShaderProgram> HardCodedLightShaderProgram;
+std::shared_ptr<Rendering::ShaderProgram> SurfaceShaderProgram;
+std::shared_ptr<Rendering::ShaderProgram> ForestLitShaderProgram;
+std::shared_ptr<Rendering::ShaderProgram> ForestFlatShaderProgram;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -57,10 +65,15 @@ void Usage()
     LogInfo("\t-x, --axiom          Specify initial string to generate from\n");
     LogInfo("\t-i, --iterations     Specify number of rewriting iterations to perform\n");
     LogInfo("\t          [NOTE] this grows exponentially\n");
+    LogInfo("\t-m, --memory         Specify the most memory a generation may use, i.e. 512M or 4G, lowering iterations to fit\n");
     LogInfo("\t-a, --angle          Specify turtle turn angle\n");
     LogInfo("\t-d, --distance       Specify turtle move distance\n");
+    LogInfo("\t-s, --seed           Specify seed used by stochastic rules\n");
     LogInfo("\t-L, --load           Specify a file to load an lsystem from\n");
     LogInfo("\t-rs, --resolution    Specify initial window resolution, WidthxHeight\n");
+    LogInfo("\t-c, --continuous     Redraw every frame, rather than only when something has changed\n");
+    LogInfo("\t-F, --forest         Specify a number of plants to scatter, drawing a forest of the system\n");
+    LogInfo("\t-S, --scene          Specify a scene file to plant a forest from, each line a system file and a count\n");
     LogInfo("\t\n");
 }
 
@@ -90,6 +103,23 @@ void ProcessArguments(int argc, char** argv)
                 i++;
             }
         }
+        else if (strcmp(argv[i], "-m") == 0 || strcmp(argv[i], "--memory") == 0)
+        {
+            if ((i + 1) < argc)
+            {
+                //a K, M or G suffix scales by powers of 1024
+                char* Suffix = nullptr;
+                double Bytes = strtod(argv[i + 1], &Suffix);
+                const char* Units = "KMG";
+                const char* Unit = *Suffix != '\0' ? strchr(Units, toupper(*Suffix)) : nullptr;
+                if (Unit != nullptr)
+                {
+                    Bytes = ldexp(Bytes, 10 * static_cast<int>(Unit - Units + 1));
+                }
+                ActiveSystem.SetMemoryBudget(static_cast<size_t>(Bytes > 0.0 ? Bytes : 0.0));
+                i++;
+            }
+        }
         else if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--angle") == 0)
         {
             if ((i + 1) < argc)
@@ -104,6 +134,14 @@ void ProcessArguments(int argc, char** argv)
                 ActiveSystem.SetDistance(strtof(argv[i + 1], nullptr));
             }
         }
+        else if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--seed") == 0)
+        {
+            if ((i + 1) < argc)
+            {
+                ActiveSystem.SetSeed(static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10)));
+                i++;
+            }
+        }
         else if (strcmp(argv[i], "-L") == 0 || strcmp(argv[i], "--load") == 0)
         {
             if ((i + 1) < argc)
@@ -114,6 +152,27 @@ void ProcessArguments(int argc, char** argv)
         else if (strcmp(argv[i], "-rs") == 0 || strcmp(argv[i], "--resolution") == 0)
         {
 
+        }
+        else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--continuous") == 0)
+        {
+            bRenderOnDemand = false;
+        }
+        else if (strcmp(argv[i], "-F") == 0 || strcmp(argv[i], "--forest") == 0)
+        {
+            if ((i + 1) < argc)
+            {
+                bForestMode = true;
+                ForestNumPlants = static_cast<int>(strtol(argv[i + 1], nullptr, 10));
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "-S") == 0 || strcmp(argv[i], "--scene") == 0)
+        {
+            if ((i + 1) < argc)
+            {
+                ForestSceneFilename = argv[i + 1];
+                i++;
+            }
         }
         else if (strcmp(argv[i], "-r") == 0)
         {
@@ -123,12 +182,29 @@ void ProcessArguments(int argc, char** argv)
             }
         }
     }
+
+    //the budget applies whatever order the iterations, rules and budget were given in
+    ActiveSystem.SetIterations(ActiveSystem.GetIterations());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// initialization functions
 bool Init(int argc, char** argv)
 {
+    //predictions count what the turtle draws and the renderer uploads, every segment's cone once per level of detail
+    LS_PrimitiveSizes Sizes;
+    Sizes.TrianglesPerSegment = ConeSegment::FullDetailSides * 2;
+    for (const int Sides : Rendering::ChunkBVH::LevelSides)
+    {
+        Sizes.UploadedTrianglesPerSegment += Sides * 2;
+    }
+    Sizes.TriangleBytes = sizeof(ColoredTriangle);
+    Sizes.SegmentBytes = sizeof(ConeSegment);
+    Sizes.VertexBytes = sizeof(Rendering::VertexLayout);
+    Sizes.VertexBufferOverhead = Rendering::StreamingBuffer::MaxBytesPerByteWritten;
+    Sizes.MaxTriangles = static_cast<double>(Turtle::MaxTriangles);
+    LSystem::SetPrimitiveSizes(Sizes);
+
     //process arguments to set variables for the active system
     ProcessArguments(argc, argv);
 
@@ -224,6 +300,19 @@ bool InitGraphics()
     const std::string HCLightFSFilename = "/resource/shader/HCLight_passthrough.fs";
     HardCodedLightShaderProgram = shaderManager->LoadShaderProgram("HardCodedLight", HCLightVSFilename, HCLightFSFilename);
 
+    const std::string SurfaceVSFilename = "/resource/shader/surface_instanced.vs";
+    const std::string SurfaceFSFilename = "/resource/shader/surface_instanced.fs";
+    SurfaceShaderProgram = shaderManager->LoadShaderProgram("SurfaceInstanced", SurfaceVSFilename, SurfaceFSFilename);
+
+    //forest plants share the model's fragment shaders, only placing their vertices per instance
+    const std::string ForestVSFilename = "/resource/shader/forest_instanced.vs";
+    ForestLitShaderProgram = shaderManager->LoadShaderProgram("ForestLit", ForestVSFilename, HCLightFSFilename);
+    ForestFlatShaderProgram = shaderManager->LoadShaderProgram("ForestFlat", ForestVSFilename, passthroughFSFilename);
+    CacheUniformLocations();
+
+    //load predefined surfaces, before the L-system's instances are uploaded
+    Rendering::SurfaceLibrary::Get()->LoadFromDirectory(myc::GetExecutableDir() + "/resource/surfaces");
+
     //initialize world axes
     InitWorldAxes();
 
@@ -243,6 +332,10 @@ bool InitGraphics()
     //set active view projection matrix uniform
     ActiveViewProjectionMatrix = MainCamera.GetViewProjectionMatrix();
 
+    //gpu timers, read back a frame or more late so they never stall
+    SceneGPUTimer.Initialize("GPU Scene");
+    UIGPUTimer.Initialize("GPU UI");
+
     //set clear color
     constexpr double Red = 0.0f;
     constexpr double Green = 0.0f;
@@ -260,36 +353,35 @@ bool InitGraphics()
     UI.SetLightingVariables(&LightLocation, &LightColor, &AmbientColor, &AmbientStrength, &bLitMode);
     UI.SetLightUpdateCallback(UpdateLightData);
 
+    //setup UI forest variables and callbacks
+    UI.SetForestVariables(&bForestMode, &ForestNumPlants, &ForestRadius, &ForestSeed);
+    UI.SetForestCallbacks(UpdateForest, AddForestSpecies, ClearForest);
+
     return true;
 }
 
 bool InitLSystems()
 {
-    //create vertax array object for storing info about bound objects and what to render
-    glGenVertexArrays(1, &ColoredVertexArrayObject);
-    glBindVertexArray(ColoredVertexArrayObject);
-
-    //create vertex buffer for storing per-vertex data
-    //specify location layout, and enable vertex attribute array
-    glGenBuffers(1, &ColoredVertexBufferObject_Positions);
-    glBindBuffer(GL_ARRAY_BUFFER, ColoredVertexBufferObject_Positions);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    glEnableVertexAttribArray(0);
-
-    //specify color layout, and enable vertex attribute array
-    glGenBuffers(1, &ColoredVertexBufferObject_Colors);
-    glBindBuffer(GL_ARRAY_BUFFER, ColoredVertexBufferObject_Colors);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    glEnableVertexAttribArray(1);
-
-    //specify color layout, and enable vertex attribute array
-    glGenBuffers(1, &ColoredVertexBufferObject_Normals);
-    glBindBuffer(GL_ARRAY_BUFFER, ColoredVertexBufferObject_Normals);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    glEnableVertexAttribArray(1);
+    //create the model's vertex array, its interleaved vertex buffer is filled by UpdateVertexBuffers
+    RenderContext.Initialize();
 
     UpdateVertexBuffers();
 
+    //a forest asked for on the command line starts with the scene's species, or the loaded system as its only one
+    if (ForestSceneFilename != nullptr)
+    {
+        const int ScenePlants = Forest.LoadFromFile(ForestSceneFilename);
+        if (ScenePlants > 0)
+        {
+            bForestMode = true;
+            ForestNumPlants = ScenePlants;
+        }
+    }
+    if (bForestMode)
+    {
+        UpdateForest();
+    }
+
     return true;
 }
 
@@ -357,9 +449,15 @@ bool InitInput()
     //set mouse scroll event callback
     glfwSetScrollCallback(MainWindow, MouseScrollEventCallback);
 
+    //set text input callback
+    glfwSetCharCallback(MainWindow, CharEventCallback);
+
     //set resize callback
     glfwSetFramebufferSizeCallback(MainWindow, WindowResizeEventCallback);
 
+    //set refresh callback, called when the window has been uncovered or restored and must be drawn again
+    glfwSetWindowRefreshCallback(MainWindow, WindowRefreshEventCallback);
+
     return true;
 }
 
@@ -368,103 +466,67 @@ bool InitInput()
 /// update functions
 void UpdateVertexBuffers()
 {
-    //ActiveSystem.SetIterations(3);
-    ActiveTurtle.Reset();
-    ActiveSystem.Reset();
-    ActiveSystem.Rewrite();
+    RequestRedraw();
 
-    //use our active turtle to draw the system and return a list of triangles
-    ActiveTurtle.DrawSystem(ActiveSystem, &TriangleList);
+    //systems drawn before, by the model or a forest, come straight from the cache rather than being generated again
+    ActiveModel = Scene::GenerationCache::Get()->Acquire(ActiveSystem);
 
     //if no triangles are present, return early
-    if (TriangleList == nullptr)
+    if (ActiveModel == nullptr)
     {
+        ModelChunks.Clear();
         return;
     }
+    const ColoredTriangleList* TriangleList = &ActiveModel->Triangles;
 
     LogInfo("loading %d triangles\n", TriangleList->NumTriangles);
 
-    //allocate memory for vertex locations and colors
-    auto* VertLocations = (glm::vec3*) malloc(TriangleList->NumTriangles * sizeof(ColoredTriangle::VertexLocations));
-    auto* VertColors = (glm::vec3*) malloc(TriangleList->NumTriangles * sizeof(ColoredTriangle::VertexColors));
-    auto* VertNormals = (glm::vec3*) malloc(TriangleList->NumTriangles * sizeof(ColoredTriangle::VertexNormals));
+    //calculate model center
+    const glm::vec3 ModelCenter = (TriangleList->BoundingBoxMin + TriangleList->BoundingBoxMax) / 2.0f;
+
+    //bucket the segments and polygons into chunks, uploaded chunk by chunk at every level of detail so each chunk
+    //is a contiguous range of vertices
+    const glm::vec3 ModelOffset(0.0f, -ModelCenter.y/2.0f, 0.0f);
+    ActiveModelOffset = ModelOffset;
+    ModelChunks.Build(*TriangleList, ActiveModel->Segments, ModelOffset);
 
-    //iterate over all vertices of all triangles, and set vert locations and colors in their respective arrays
-    for (int TriangleIndex = 0; TriangleIndex < TriangleList->NumTriangles; TriangleIndex++)
+    //map space for the vertices, which are written interleaved straight into GPU visible memory
+    Rendering::VertexLayout* Vertices = RenderContext.BeginModelUpload(ModelChunks.GetNumVertices());
+    if (Vertices != nullptr)
     {
-        for (int VertIndex = 0; VertIndex < 3; VertIndex++)
-        {
-            glm::vec3& vert = TriangleList->TriData[TriangleIndex].VertexLocations[VertIndex];
-            glm::vec3& color = TriangleList->TriData[TriangleIndex].VertexColors[VertIndex];
-            glm::vec3& normal = TriangleList->TriData[TriangleIndex].VertexNormals[VertIndex];
-
-            VertLocations[TriangleIndex * 3 + VertIndex] = vert;
-            VertColors[TriangleIndex * 3 + VertIndex] = color;
-            VertNormals[TriangleIndex * 3 + VertIndex] = normal;
-        }
+        ModelChunks.WriteVertices(Vertices);
     }
 
-    //calculate model center
-    const glm::vec3 ModelCenter = (TriangleList->BoundingBoxMin + TriangleList->BoundingBoxMax) / 2.0f;
-
-    for (int TriangleIndex = 0; TriangleIndex < TriangleList->NumTriangles; TriangleIndex++)
+    if (!RenderContext.EndModelUpload())
     {
-        for(int v = 0; v < 3; v++)
-        {
-            VertLocations[TriangleIndex*3 + v].y -= ModelCenter.y/2.0f;
-        }
+        LogWarning("could not write vertex data, the model will not be drawn\n");
+        ModelChunks.Clear();
     }
 
+    //predefined surfaces are drawn instanced, only their placements are uploaded
+    UploadSurfaceInstances();
+
     //update view distance
     const float Distance = glm::length(TriangleList->BoundingBoxMax.y - TriangleList->BoundingBoxMin.y);
     ViewDistance = Distance / (2.0f * glm::tan(FoV_y / 2.f)) * 1.25;
     ViewDistance = 15.0f;
-
-    {
-        //create vertax array object for storing info about bound objects and what to render
-        glBindVertexArray(ColoredVertexArrayObject);
-
-        //create vertex buffer for storing per-vertex data
-        glBindBuffer(GL_ARRAY_BUFFER, ColoredVertexBufferObject_Positions);
-        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(TriangleList->NumTriangles * sizeof(ColoredTriangle::VertexLocations)),
-                     reinterpret_cast<GLfloat*>(VertLocations), GL_STATIC_DRAW);
-        //specify location layout, and enable vertex attribute array
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-        glEnableVertexAttribArray(0);
-
-        glBindBuffer(GL_ARRAY_BUFFER, ColoredVertexBufferObject_Colors);
-        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(TriangleList->NumTriangles * sizeof(ColoredTriangle::VertexColors)),
-                     reinterpret_cast<GLfloat*>(VertColors), GL_STATIC_DRAW);
-        //specify color layout, and enable vertex attribute array
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-        glEnableVertexAttribArray(1);
-
-        glBindBuffer(GL_ARRAY_BUFFER, ColoredVertexBufferObject_Normals);
-        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(TriangleList->NumTriangles * sizeof(ColoredTriangle::VertexNormals)),
-                     reinterpret_cast<GLfloat*>(VertNormals), GL_STATIC_DRAW);
-        //specify color layout, and enable vertex attribute array
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-        glEnableVertexAttribArray(2);
-    }
-
-    //free heap-allocated memory
-    free(VertLocations);
-    free(VertColors);
-    free(VertNormals);
 }
 
 void UpdateLightData()
 {
-    std::vector<glm::vec3> LightVerts = GenerateSphere(LightLocation, LightRadius, VerticalSections, HorizontalSections);
-    LightVertCount = static_cast<int>(LightVerts.size());
+    RequestRedraw();
+    UploadArena.Reset();
+    glm::vec3* VertLocations = GenerateSphere(LightLocation, LightRadius, VerticalSections, HorizontalSections, UploadArena, LightVertCount);
+    auto* VertColors = UploadArena.AllocateArray<glm::vec3>(LightVertCount);
+    if (VertLocations == nullptr || VertColors == nullptr)
+    {
+        LightVertCount = 0;
+        return;
+    }
 
     LogInfo("LightVertCount = %d", LightVertCount);
-    auto* VertLocations = static_cast<glm::vec3*>(malloc(LightVertCount * sizeof(glm::vec3)));
-    auto* VertColors = static_cast<glm::vec3*>(malloc(LightVertCount * sizeof(glm::vec3)));
-
     for(int i = 0; i < LightVertCount; i++)
     {
-        VertLocations[i] = LightVerts[i];
         VertColors[i] = LightColor;
     }
 
@@ -493,6 +555,8 @@ void Run()
 {
     LogInfo("run started at time %lfs, running...\n", glfwGetTime());
 
+    //the first frames are always drawn
+    RequestRedraw();
     while (!bRequestedExit)
     {
         UpdateTiming(MainWindow);
@@ -504,10 +568,78 @@ void Run()
     LogInfo("running complete.\n");
 }
 
-void Tick(double DeltaTime)
+void RequestRedraw()
 {
-    ActiveViewProjectionMatrix = MainCamera.GetViewProjectionMatrix();
+    PendingRedrawFrames = RedrawFramesPerChange;
+}
+
+bool IsAnimating()
+{
+    const bool bCameraInputHeld = bLMBHeld || bMMBHeld || ManualYawInput != 0 || ManualPitchInput != 0 || ManualRollInput != 0;
+    return bCameraInputHeld || PendingRedrawFrames > 0;
+}
+
+void CacheUniformLocations()
+{
+    //uniform blocks are bound to their binding points by the programs themselves, only loose uniforms are kept here
+    LitTwoSidedLocation = HardCodedLightShaderProgram->GetUniformLocation("twoSided");
+    SurfaceLitModeLocation = SurfaceShaderProgram->GetUniformLocation("litMode");
+    ForestTwoSidedLocation = ForestLitShaderProgram->GetUniformLocation("twoSided");
+}
+
+void UpdateForest()
+{
+    RequestRedraw();
+
+    //entering forest mode without any species plants the current model
+    if (bForestMode && Forest.GetNumSpecies() == 0)
+    {
+        Forest.AddSpecies(ActiveModel);
+    }
+
+    ForestNumPlants = glm::max(ForestNumPlants, 0);
+    Forest.Scatter(ForestNumPlants, ForestRadius, static_cast<uint32_t>(ForestSeed));
+    LogInfo("scattered %zu plants of %d species\n", Forest.GetNumPlants(), Forest.GetNumSpecies());
+
+    //leaving forest mode comes through here as well, which puts back the model's surfaces
+    UploadSurfaceInstances();
+}
+
+void AddForestSpecies()
+{
+    if (Forest.AddSpecies(ActiveModel) < 0)
+    {
+        return;
+    }
+
+    UpdateForest();
+}
+
+void ClearForest()
+{
+    RequestRedraw();
+    Forest.Clear();
+    UploadSurfaceInstances();
+}
+
+void UploadSurfaceInstances()
+{
+    static const std::vector<SurfaceInstance> NoInstances[Rendering::SurfaceLibrary::MaxSurfaces];
+
+    Rendering::SurfaceLibrary* Surfaces = Rendering::SurfaceLibrary::Get();
+    if (bForestMode)
+    {
+        Surfaces->UploadInstances(Forest.GetSurfaceInstances(), glm::vec3(0.0f));
+    }
+    else
+    {
+        Surfaces->UploadInstances(ActiveModel != nullptr ? ActiveModel->SurfaceInstances : NoInstances, ActiveModelOffset);
+    }
+    LogInfo("loading %d surface instances\n", static_cast<int>(Surfaces->GetNumInstances()));
+}
 
+void Tick(double DeltaTime)
+{
     //update mouse info if LMB or MMB are held
     if(bLMBHeld || bMMBHeld)
     {
@@ -544,24 +676,51 @@ void Tick(double DeltaTime)
     {
         MainCamera.AdjustRoll(static_cast<float>(-ManualRollInput * ManualRotationSpeed * DeltaTime));
     }
+
+    //any change to the camera, from input here or from callbacks, needs the scene drawn again
+    const glm::mat4 ViewProjectionMatrix = MainCamera.GetViewProjectionMatrix();
+    if (ViewProjectionMatrix != ActiveViewProjectionMatrix)
+    {
+        ActiveViewProjectionMatrix = ViewProjectionMatrix;
+        RequestRedraw();
+    }
 }
 
 void Render(double DeltaTime)
 {
+    //nothing has changed since the last frames drawn, the window still shows them
+    if (bRenderOnDemand)
+    {
+        if (PendingRedrawFrames <= 0)
+        {
+            return;
+        }
+        PendingRedrawFrames--;
+    }
+
+    //the previous frame drawn ends where this one begins, so everything it did, its own Render included, is counted
+    Profiler::Get()->EndFrame();
+    PROFILE_SCOPE("Render");
+
     //clear the color and depth buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    //update uniform variables, in this case just ViewProjectionMatrix
-    //glUniformMatrix4fv(glGetUniformLocation(PassthroughShaderProgram->GetProgramID(), "ViewProjectionMatrix"), 1, GL_FALSE,
-    //                   (GLfloat*) &ActiveViewProjectionMatrix);
+    //update the state shared by every program, which is only uploaded if it has changed since last frame
+    Rendering::GlobalUniforms Uniforms;
+    Uniforms.ViewMatrix = MainCamera.GetViewMatrix();
+    Uniforms.ProjectionMatrix = MainCamera.GetProjectionMatrix();
+    Uniforms.ViewProjectionMatrix = ActiveViewProjectionMatrix;
+    Uniforms.LightPosition = LightLocation;
+    Uniforms.LightColor = LightColor;
+    Uniforms.AmbientColor = AmbientColor;
+    Uniforms.AmbientStrength = AmbientStrength;
+    RenderContext.UpdateGlobalUniforms(Uniforms);
+
     //render axes and light
+    SceneGPUTimer.Begin();
     {
         //enable the passthrough shader program
         glUseProgram(PassthroughShaderProgram->GetProgramID());
-        glUniformMatrix4fv(glGetUniformLocation(PassthroughShaderProgram->GetProgramID(), "ViewProjectionMatrix"),
-                           1,
-                           GL_FALSE,
-                           reinterpret_cast<GLfloat*>(&ActiveViewProjectionMatrix));
 
         //bind and draw AxesVAO
         glBindVertexArray(AxesVAO);
@@ -571,40 +730,93 @@ void Render(double DeltaTime)
         glBindVertexArray(LightVAO);
         glDrawArrays(GL_TRIANGLES, 0, LightVertCount);
 
-        //render the L-system model, lit or flat-shaded depending on bLitMode
-        glBindVertexArray(ColoredVertexArrayObject);
-        const std::shared_ptr<Rendering::ShaderProgram>& ActiveModelShaderProgram = bLitMode ? HardCodedLightShaderProgram : PassthroughShaderProgram;
-        glUseProgram(ActiveModelShaderProgram->GetProgramID());
-        glUniformMatrix4fv(glGetUniformLocation(ActiveModelShaderProgram->GetProgramID(), "ViewProjectionMatrix"), 1, GL_FALSE,
-                           reinterpret_cast<GLfloat*>(&ActiveViewProjectionMatrix));
-        if(bLitMode)
+        //draw the forest in place of the model, every plant of a species in one instanced draw. Plants are drawn
+        //whole, without the model's culling or levels of detail, and their surfaces are drawn with the model's below
+        if (bForestMode)
         {
-            glUniform3fv(glGetUniformLocation(ActiveModelShaderProgram->GetProgramID(), "lightPosition"), 1, reinterpret_cast<GLfloat*>(&LightLocation));
-            glUniform3fv(glGetUniformLocation(ActiveModelShaderProgram->GetProgramID(), "lightColor"), 1, reinterpret_cast<GLfloat*>(&LightColor));
-            glUniform3fv(glGetUniformLocation(ActiveModelShaderProgram->GetProgramID(), "ambientColor"), 1, reinterpret_cast<GLfloat*>(&AmbientColor));
-            glUniform1f(glGetUniformLocation(ActiveModelShaderProgram->GetProgramID(), "ambientStrength"), AmbientStrength);
+            const std::shared_ptr<Rendering::ShaderProgram>& ForestShaderProgram = bLitMode ? ForestLitShaderProgram : ForestFlatShaderProgram;
+            const GLint TwoSidedLocation = bLitMode ? ForestTwoSidedLocation : -1;
+            glUseProgram(ForestShaderProgram->GetProgramID());
+
+            glUniform1i(TwoSidedLocation, GL_FALSE);
+            Forest.Draw(false);
+            glUniform1i(TwoSidedLocation, GL_TRUE);
+            glDisable(GL_CULL_FACE);
+            Forest.Draw(true);
+            glEnable(GL_CULL_FACE);
         }
+        else
+        {
+            //render the L-system model, lit or flat-shaded depending on bLitMode
+            RenderContext.BindModel();
+            const std::shared_ptr<Rendering::ShaderProgram>& ActiveModelShaderProgram = bLitMode ? HardCodedLightShaderProgram : PassthroughShaderProgram;
+            const GLint TwoSidedLocation = bLitMode ? LitTwoSidedLocation : -1;
+            glUseProgram(ActiveModelShaderProgram->GetProgramID());
+
+            //draw the chunks of the model in view at the detail their distance calls for, closed segments first, then
+            //polygons visible from both sides
+            const Rendering::Frustum ViewFrustum(ActiveViewProjectionMatrix);
+            glUniform1i(TwoSidedLocation, GL_FALSE);
+            ModelChunks.DrawVisible(ViewFrustum, static_cast<float>(Height), false);
+            glUniform1i(TwoSidedLocation, GL_TRUE);
+            glDisable(GL_CULL_FACE);
+            ModelChunks.DrawVisible(ViewFrustum, static_cast<float>(Height), true);
+            glEnable(GL_CULL_FACE);
+        }
+
+        //draw predefined surfaces, of the model or of every plant, one instanced draw per surface. They're single
+        //sheets, so both sides are drawn
+        if(Rendering::SurfaceLibrary::Get()->GetNumInstances() > 0)
+        {
+            glUseProgram(SurfaceShaderProgram->GetProgramID());
+            glUniform1i(SurfaceLitModeLocation, bLitMode);
 
-        //bind and draw ColoredVertexArrayObject
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(TriangleList->NumTriangles * 3));
+            glDisable(GL_CULL_FACE);
+            Rendering::SurfaceLibrary::Get()->Draw();
+            glEnable(GL_CULL_FACE);
+        }
     }
 
+    SceneGPUTimer.End();
+
     // Render ImGui elements
+    UIGPUTimer.Begin();
     UIManager::BeginFrame();
     UI.DrawSystemMenu(&ActiveSystem);
     UIManager::DrawMainMenuBar();
     UI.DrawLightMenu();
+    UI.DrawForestMenu(Forest.GetNumSpecies(), Forest.GetNumPlants());
+    UI.DrawProfilerMenu(ProfilerTraceFilename);
     UIManager::EndFrame();
+    UIGPUTimer.End();
 
 
     //swap front and back buffers
     glfwSwapBuffers(MainWindow);
+    FrameCount++;
 }
 
 void ProcessInput()
 {
-    //poll queued events
-    glfwPollEvents();
+    if (bRenderOnDemand && !IsAnimating())
+    {
+        //nothing to draw until something happens, so sleep until an event arrives
+        glfwWaitEventsTimeout(IdleWaitTimeout);
+
+        //a focused text field still needs its caret blinking while idle
+        if (ImGui::GetIO().WantTextInput)
+        {
+            RequestRedraw();
+        }
+
+        //time spent asleep isn't part of the next frame, or held keys would jump the camera when it wakes
+        LastFrameTime = glfwGetTime();
+    }
+    else
+    {
+        //poll queued events
+        glfwPollEvents();
+    }
 
     //request exit if window x has been clicked
     if (glfwWindowShouldClose(MainWindow))
@@ -619,9 +831,14 @@ void Cleanup()
 {
     LogInfo("cleaning up...\n");
 
-    if(TriangleList != nullptr) {
-        free(TriangleList);
-    }
+    //let go of the model, the cache frees it once nothing else holds it
+    ActiveModel.reset();
+
+    //GPU buffers go while the context they belong to is still alive
+    RenderContext.Release();
+    Forest.Release();
+    SceneGPUTimer.Release();
+    UIGPUTimer.Release();
 
     //cleanup imgui
     UIManager::Shutdown();
@@ -652,6 +869,7 @@ void KeyboardEventCallback(GLFWwindow* Window, int KeyCode, int ScanCode, int Ac
 {
     //call ImGui callback
     ImGui_ImplGlfw_KeyCallback(Window, KeyCode, ScanCode, Action, Modifiers);
+    RequestRedraw();
 
     //prevent further input processing if input being captured by imgui
     if(ImGui::GetIO().WantCaptureKeyboard)
@@ -669,6 +887,10 @@ void KeyboardEventCallback(GLFWwindow* Window, int KeyCode, int ScanCode, int Ac
     {
         PassthroughShaderProgram->ReloadShaderObjects();
         HardCodedLightShaderProgram->ReloadShaderObjects();
+        SurfaceShaderProgram->ReloadShaderObjects();
+        ForestLitShaderProgram->ReloadShaderObjects();
+        ForestFlatShaderProgram->ReloadShaderObjects();
+        CacheUniformLocations();
     }
     else if (KeyCode == GLFW_KEY_RIGHT)
     {
@@ -743,6 +965,10 @@ void MouseMoveEventCallback(GLFWwindow* Window, double xPos, double yPos)
     //call ImGui callback
     ImGui_ImplGlfw_CursorPosCallback(Window, xPos, yPos);
 
+    //every move redraws, as WantCaptureMouse is from the last frame drawn and is stale when the cursor has just
+    //moved onto a panel, whose hovered widgets and tooltips need drawing. Idle still sleeps while the mouse is still
+    RequestRedraw();
+
     //prevent further input processing if input being captured by imgui
     if(ImGui::GetIO().WantCaptureMouse)
     {
@@ -791,6 +1017,7 @@ void MouseButtonEventCallback(GLFWwindow* Window, int button, int action, int mo
 {
     //call ImGui callback
     ImGui_ImplGlfw_MouseButtonCallback(Window, button, action, mods);
+    RequestRedraw();
 
     if(button == GLFW_MOUSE_BUTTON_LEFT)
     {
@@ -823,6 +1050,7 @@ void MouseScrollEventCallback(GLFWwindow* Window, double xOffset, double yOffset
 {
     //call ImGui callback
     ImGui_ImplGlfw_ScrollCallback(Window, xOffset, yOffset);
+    RequestRedraw();
 
     MainCamera.SetLocation(MainCamera.GetLocation() - MainCamera.GetForwardVector() * (float)(ViewDistance * 0.1 * yOffset));
 }
@@ -844,7 +1072,22 @@ void WindowResizeEventCallback(GLFWwindow* Window, int NewWidth, int NewHeight)
     }
 
     glViewport(0, 0, NewWidth, NewHeight);
+    Width = NewWidth;
+    Height = NewHeight;
     LogInfo("Window resized to %dx%d\n", NewWidth, NewHeight);
+    RequestRedraw();
+}
+
+void CharEventCallback(GLFWwindow* Window, unsigned int Codepoint)
+{
+    //call ImGui callback
+    ImGui_ImplGlfw_CharCallback(Window, Codepoint);
+    RequestRedraw();
+}
+
+void WindowRefreshEventCallback([[maybe_unused]] GLFWwindow* Window)
+{
+    RequestRedraw();
 }
 
 void UpdateTiming(GLFWwindow* Window)
@@ -868,7 +1111,6 @@ void UpdateTiming(GLFWwindow* Window)
         glfwSetWindowTitle(Window, tmp);
         FrameCount = 0;
     }
-    FrameCount++;
 }
 
 
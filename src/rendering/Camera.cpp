@@ -55,9 +55,14 @@ const glm::mat4& Camera::GetProjectionMatrix() const
     return ProjectionMatrix;
 }
 
+glm::mat4 Camera::GetViewMatrix()
+{
+    return inverse(GetMatrix());
+}
+
 glm::mat4 Camera::GetViewProjectionMatrix()
 {
-    return ProjectionMatrix * inverse(GetMatrix());
+    return ProjectionMatrix * GetViewMatrix();
 }
 
 void Camera::UpdateProjectionMatrix()
@@ -0,0 +1,300 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "rendering/ChunkBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include "glad/glad.h"
+#include "myc/logging/logging.h"
+#include "rendering/RenderingContext.h"
+#include "utility/Profiler.h"
+
+namespace Rendering
+{
+    //distance between a circle and the polygon of N sides inscribed in it, relative to the radius, per level
+    static const float LevelErrors[ChunkBVH::NumLevels] = {
+        static_cast<float>(1.0 - cos(M_PI / ChunkBVH::LevelSides[0])),
+        static_cast<float>(1.0 - cos(M_PI / ChunkBVH::LevelSides[1])),
+        static_cast<float>(1.0 - cos(M_PI / ChunkBVH::LevelSides[2])),
+    };
+
+    void ChunkBVH::Clear()
+    {
+        Nodes.clear();
+        PrimitiveOrder.clear();
+        OneSided = Hierarchy();
+        TwoSided = Hierarchy();
+        NumLeaves = 0;
+        NumVertices = 0;
+    }
+
+    void ChunkBVH::Build(const ColoredTriangleList& List, const std::vector<ConeSegment>& Segments, const glm::vec3& Offset)
+    {
+        PROFILE_SCOPE("Chunk Build");
+
+        Clear();
+        SourceList = &List;
+        SourceSegments = &Segments;
+        VertexOffset = Offset;
+
+        //one sided triangles are drawn from segments, cones of FullDetailSides * 2 triangles each
+        const auto FirstTwoSided = static_cast<uint32_t>(List.FirstTwoSidedTriangle);
+        const auto NumTwoSided = static_cast<uint32_t>(List.NumTriangles) - FirstTwoSided;
+        bHasSegments = Segments.size() * ConeSegment::FullDetailSides * 2 == FirstTwoSided;
+        if (!bHasSegments)
+        {
+            LogWarning("model segments don't match its triangles, drawing it without levels of detail\n");
+        }
+        const auto NumOneSided = bHasSegments ? static_cast<uint32_t>(Segments.size()) : FirstTwoSided;
+        const uint32_t NumPrimitives = NumOneSided + NumTwoSided;
+
+        PrimitiveOrder.resize(NumPrimitives);
+        PrimitiveBoundsMin.resize(NumPrimitives);
+        PrimitiveBoundsMax.resize(NumPrimitives);
+        PrimitiveRadii.resize(NumPrimitives);
+        for (uint32_t Primitive = 0; Primitive < NumPrimitives; Primitive++)
+        {
+            PrimitiveOrder[Primitive] = Primitive;
+            if (bHasSegments && Primitive < NumOneSided)
+            {
+                //the cone lies within its radius of the segment's axis
+                const ConeSegment& Segment = Segments[Primitive];
+                const float Radius = Segment.GetMaxRadius();
+                PrimitiveBoundsMin[Primitive] = glm::min(Segment.Start, Segment.End) - Radius + VertexOffset;
+                PrimitiveBoundsMax[Primitive] = glm::max(Segment.Start, Segment.End) + Radius + VertexOffset;
+                PrimitiveRadii[Primitive] = Radius;
+                continue;
+            }
+
+            const uint32_t TriangleIndex = Primitive < NumOneSided ? Primitive : FirstTwoSided + (Primitive - NumOneSided);
+            const glm::vec3* Vertices = List.TriData[TriangleIndex].VertexLocations;
+            PrimitiveBoundsMin[Primitive] = glm::min(glm::min(Vertices[0], Vertices[1]), Vertices[2]) + VertexOffset;
+            PrimitiveBoundsMax[Primitive] = glm::max(glm::max(Vertices[0], Vertices[1]), Vertices[2]) + VertexOffset;
+            PrimitiveRadii[Primitive] = 0.0f;
+        }
+
+        //each level of the one sided primitives is uploaded whole, then the two sided triangles
+        OneSided.FirstPrimitive = 0;
+        OneSided.NumDetailLevels = bHasSegments ? NumLevels : 1;
+        TwoSided.FirstPrimitive = NumOneSided;
+        uint32_t Vertex = 0;
+        for (int Level = 0; Level < OneSided.NumDetailLevels; Level++)
+        {
+            OneSided.TrianglesPerPrimitive[Level] = bHasSegments ? LevelSides[Level] * 2 : 1;
+            OneSided.FirstVertex[Level] = Vertex;
+            Vertex += NumOneSided * OneSided.TrianglesPerPrimitive[Level] * 3;
+        }
+        TwoSided.FirstVertex[0] = Vertex;
+        NumVertices = Vertex + NumTwoSided * 3;
+
+        //median splits leave every chunk at least half full, and a binary tree has fewer than twice as many nodes
+        Nodes.reserve(4 * (NumPrimitives / LeafSize + 2));
+        OneSided.Root = NumOneSided > 0 ? BuildNode(0, NumOneSided) : -1;
+        TwoSided.Root = NumTwoSided > 0 ? BuildNode(NumOneSided, NumTwoSided) : -1;
+    }
+
+    int32_t ChunkBVH::BuildNode(const uint32_t First, const uint32_t Count)
+    {
+        const auto NodeIndex = static_cast<int32_t>(Nodes.size());
+        Nodes.push_back({glm::vec3(0.0f), First, glm::vec3(0.0f), Count, -1, 0.0f});
+
+        if (Count <= LeafSize)
+        {
+            glm::vec3 BoundsMin(ColoredTriangleList::FLOAT_MAX);
+            glm::vec3 BoundsMax(-ColoredTriangleList::FLOAT_MAX);
+            float MaxRadius = 0.0f;
+            for (uint32_t i = First; i < First + Count; i++)
+            {
+                const uint32_t Primitive = PrimitiveOrder[i];
+                BoundsMin = glm::min(BoundsMin, PrimitiveBoundsMin[Primitive]);
+                BoundsMax = glm::max(BoundsMax, PrimitiveBoundsMax[Primitive]);
+                MaxRadius = std::max(MaxRadius, PrimitiveRadii[Primitive]);
+            }
+            Nodes[NodeIndex].BoundsMin = BoundsMin;
+            Nodes[NodeIndex].BoundsMax = BoundsMax;
+            Nodes[NodeIndex].MaxRadius = MaxRadius;
+            NumLeaves++;
+            return NodeIndex;
+        }
+
+        //split at the median along the axis the primitives' centers are most spread out on
+        glm::vec3 CentersMin(ColoredTriangleList::FLOAT_MAX);
+        glm::vec3 CentersMax(-ColoredTriangleList::FLOAT_MAX);
+        for (uint32_t i = First; i < First + Count; i++)
+        {
+            const uint32_t Primitive = PrimitiveOrder[i];
+            const glm::vec3 Center = PrimitiveBoundsMin[Primitive] + PrimitiveBoundsMax[Primitive];
+            CentersMin = glm::min(CentersMin, Center);
+            CentersMax = glm::max(CentersMax, Center);
+        }
+        const glm::vec3 Extent = CentersMax - CentersMin;
+        const int Axis = Extent.x > Extent.y ? (Extent.x > Extent.z ? 0 : 2) : (Extent.y > Extent.z ? 1 : 2);
+
+        const uint32_t Half = Count / 2;
+        uint32_t* Order = PrimitiveOrder.data();
+        std::nth_element(Order + First, Order + First + Half, Order + First + Count,
+                         [this, Axis](const uint32_t A, const uint32_t B)
+                         {
+                             return PrimitiveBoundsMin[A][Axis] + PrimitiveBoundsMax[A][Axis] < PrimitiveBoundsMin[B][Axis] + PrimitiveBoundsMax[B][Axis];
+                         });
+
+        const int32_t LeftChild = BuildNode(First, Half);
+        const int32_t RightChild = BuildNode(First + Half, Count - Half);
+        Node& Parent = Nodes[NodeIndex];
+        Parent.RightChild = RightChild;
+        Parent.BoundsMin = glm::min(Nodes[LeftChild].BoundsMin, Nodes[RightChild].BoundsMin);
+        Parent.BoundsMax = glm::max(Nodes[LeftChild].BoundsMax, Nodes[RightChild].BoundsMax);
+        Parent.MaxRadius = std::max(Nodes[LeftChild].MaxRadius, Nodes[RightChild].MaxRadius);
+        return NodeIndex;
+    }
+
+    VertexLayout* ChunkBVH::WritePrimitive(const Hierarchy& Tree, const uint32_t Primitive, const int Level,
+                                           ColoredTriangle* Scratch, VertexLayout* Vertices) const
+    {
+        const ColoredTriangle* Triangles;
+        uint32_t NumTriangles = Tree.TrianglesPerPrimitive[Level];
+        if (&Tree == &OneSided && bHasSegments)
+        {
+            //full detail is the turtle's own triangles, coarser levels are drawn again from the segment
+            if (Level == 0)
+            {
+                Triangles = SourceList->TriData + Primitive * NumTriangles;
+            }
+            else
+            {
+                (*SourceSegments)[Primitive].Triangulate(LevelSides[Level], Scratch);
+                Triangles = Scratch;
+            }
+        }
+        else
+        {
+            const uint32_t TriangleIndex = &Tree == &OneSided ? Primitive : static_cast<uint32_t>(SourceList->FirstTwoSidedTriangle) + (Primitive - Tree.FirstPrimitive);
+            Triangles = SourceList->TriData + TriangleIndex;
+        }
+
+        for (uint32_t TriangleIndex = 0; TriangleIndex < NumTriangles; TriangleIndex++)
+        {
+            const ColoredTriangle& Triangle = Triangles[TriangleIndex];
+            for (int VertIndex = 0; VertIndex < 3; VertIndex++)
+            {
+                VertexLayout& Vertex = *Vertices++;
+                Vertex.Location = Triangle.VertexLocations[VertIndex] + VertexOffset;
+                Vertex.Color = Triangle.VertexColors[VertIndex];
+                Vertex.Normals = Triangle.VertexNormals[VertIndex];
+            }
+        }
+        return Vertices;
+    }
+
+    void ChunkBVH::WriteVertices(VertexLayout* Vertices) const
+    {
+        PROFILE_SCOPE("Vertex Repack");
+
+        ColoredTriangle Scratch[ConeSegment::MaxSides * 2];
+        for (const Hierarchy* Tree : {&OneSided, &TwoSided})
+        {
+            const uint32_t End = Tree == &OneSided ? TwoSided.FirstPrimitive : static_cast<uint32_t>(PrimitiveOrder.size());
+            for (int Level = 0; Level < Tree->NumDetailLevels; Level++)
+            {
+                for (uint32_t i = Tree->FirstPrimitive; i < End; i++)
+                {
+                    Vertices = WritePrimitive(*Tree, PrimitiveOrder[i], Level, Scratch, Vertices);
+                }
+            }
+        }
+    }
+
+    int ChunkBVH::SelectLevel(const Hierarchy& Tree, const float Radius, const float Depth, const float PixelScale) const
+    {
+        //behind or around the camera there's no telling how large the error gets
+        if (Depth <= 0.0f || MaxScreenError <= 0.0f)
+        {
+            return 0;
+        }
+
+        for (int Level = Tree.NumDetailLevels - 1; Level > 0; Level--)
+        {
+            if (Radius * LevelErrors[Level] * PixelScale / Depth <= MaxScreenError)
+            {
+                return Level;
+            }
+        }
+        return 0;
+    }
+
+    void ChunkBVH::AddDrawRange(const Hierarchy& Tree, const Node& Range, const int Level)
+    {
+        const uint32_t NumRangeVertices = Range.NumPrimitives * Tree.TrianglesPerPrimitive[Level] * 3;
+        const auto First = static_cast<int>(Tree.FirstVertex[Level] + (Range.FirstPrimitive - Tree.FirstPrimitive) * Tree.TrianglesPerPrimitive[Level] * 3);
+        if (!DrawFirsts.empty() && DrawFirsts.back() + DrawCounts.back() == First)
+        {
+            DrawCounts.back() += static_cast<int>(NumRangeVertices);
+        }
+        else
+        {
+            DrawFirsts.push_back(First);
+            DrawCounts.push_back(static_cast<int>(NumRangeVertices));
+        }
+    }
+
+    uint32_t ChunkBVH::DrawVisible(const Frustum& ViewFrustum, const float ViewportHeight, const bool bTwoSided)
+    {
+        const Hierarchy& Tree = bTwoSided ? TwoSided : OneSided;
+        if (Tree.Root < 0)
+        {
+            return 0;
+        }
+
+        DrawFirsts.clear();
+        DrawCounts.clear();
+        uint32_t NumDrawn = 0;
+
+        //pixels covered by one world unit at a depth of one
+        const float PixelScale = ViewFrustum.VerticalScale * ViewportHeight * 0.5f;
+
+        //depth first, left before right, so ranges come out in order and neighbours can be merged
+        int32_t Pending[64];
+        int NumPending = 0;
+        Pending[NumPending++] = Tree.Root;
+        while (NumPending > 0)
+        {
+            const int32_t NodeIndex = Pending[--NumPending];
+            const Node& Current = Nodes[NodeIndex];
+            const bool bLeaf = Current.RightChild < 0;
+            const EFrustumTest Test = ViewFrustum.TestBox(Current.BoundsMin, Current.BoundsMax);
+            if (Test == EFrustumTest::Outside)
+            {
+                continue;
+            }
+
+            //a node in view is drawn whole if all of it calls for the same level of detail
+            bool bDrawWhole = bLeaf;
+            int Level = 0;
+            if (Test == EFrustumTest::Inside || bLeaf)
+            {
+                float NearDepth, FarDepth;
+                ViewFrustum.GetDepthRange(Current.BoundsMin, Current.BoundsMax, NearDepth, FarDepth);
+                Level = SelectLevel(Tree, Current.MaxRadius, NearDepth, PixelScale);
+                bDrawWhole = bLeaf || Level == SelectLevel(Tree, Current.MaxRadius, FarDepth, PixelScale);
+            }
+
+            if (!bDrawWhole)
+            {
+                Pending[NumPending++] = Current.RightChild;
+                Pending[NumPending++] = NodeIndex + 1;
+                continue;
+            }
+
+            AddDrawRange(Tree, Current, Level);
+            NumDrawn += Current.NumPrimitives * Tree.TrianglesPerPrimitive[Level];
+        }
+
+        if (!DrawFirsts.empty())
+        {
+            glMultiDrawArrays(GL_TRIANGLES, DrawFirsts.data(), DrawCounts.data(), static_cast<GLsizei>(DrawFirsts.size()));
+        }
+        return NumDrawn;
+    }
+}
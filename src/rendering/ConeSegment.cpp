@@ -0,0 +1,62 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "rendering/ConeSegment.h"
+
+#include <cmath>
+
+void ConeSegment::Triangulate(const int NumSides, ColoredTriangle* Triangles) const
+{
+    glm::vec3 CircleStart[MaxSides];
+    glm::vec3 CircleEnd[MaxSides];
+
+    //circular cross sections, the end one turned half a side so the sides are triangles rather than quads
+    for (int i = 0; i < NumSides; ++i)
+    {
+        double angle = (2.0f * M_PI * i) / NumSides;
+        double angle2= angle + (2.0f * M_PI * 0.5) / NumSides;
+        double x = cos(angle);
+        double z = sin(angle);
+        double x2 = cos(angle2);
+        double z2 = sin(angle2);
+        auto r1x = static_cast<float>(StartRadius * x);
+        auto r1z = static_cast<float>(StartRadius * z);
+        auto r2x2 = static_cast<float>(EndRadius * x2);
+        auto r2z2 = static_cast<float>(EndRadius * z2);
+        CircleStart[i] = Start + Right * r1x + Up * r1z;
+        CircleEnd[i] = End + Right * r2x2 + Up * r2z2;
+    }
+
+    //two triangles per side
+    for (int CurrentIndex = 0; CurrentIndex < NumSides; ++CurrentIndex)
+    {
+        const int NextIndex = (CurrentIndex + 1) % NumSides;
+
+        ColoredTriangle& t1 = Triangles[CurrentIndex * 2];
+        t1.VertexLocations[0] = CircleStart[CurrentIndex];
+        t1.VertexLocations[1] = CircleStart[NextIndex];
+        t1.VertexLocations[2] = CircleEnd[CurrentIndex];
+        t1.VertexColors[0] = StartColor;
+        t1.VertexColors[1] = StartColor;
+        t1.VertexColors[2] = EndColor;
+        glm::vec3 normal = glm::cross(t1.VertexLocations[1] - t1.VertexLocations[0], t1.VertexLocations[2] - t1.VertexLocations[0]);
+        for (auto& Normal : t1.VertexNormals)
+        {
+            Normal = normal;
+        }
+
+        ColoredTriangle& t2 = Triangles[CurrentIndex * 2 + 1];
+        t2.VertexLocations[0] = CircleEnd[NextIndex];
+        t2.VertexLocations[1] = CircleEnd[CurrentIndex];
+        t2.VertexLocations[2] = CircleStart[NextIndex];
+        t2.VertexColors[0] = EndColor;
+        t2.VertexColors[1] = EndColor;
+        t2.VertexColors[2] = StartColor;
+        normal = glm::cross(t2.VertexLocations[1] - t2.VertexLocations[0], t2.VertexLocations[2] - t2.VertexLocations[0]);
+        for (auto& Normal : t2.VertexNormals)
+        {
+            Normal = normal;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "rendering/GPUTimer.h"
+
+#include "glad/glad.h"
+#include "utility/Profiler.h"
+
+namespace Rendering
+{
+    void GPUTimer::Initialize(const char* Name)
+    {
+        glGenQueries(NumQueries, Queries);
+        Stage = Profiler::Get()->RegisterStage(Name, true);
+    }
+
+    void GPUTimer::Release()
+    {
+        if (Queries[0] != 0)
+        {
+            glDeleteQueries(NumQueries, Queries);
+        }
+        for (int i = 0; i < NumQueries; i++)
+        {
+            Queries[i] = 0;
+            bInFlight[i] = false;
+        }
+        ActiveQuery = -1;
+    }
+
+    bool GPUTimer::Collect(const int Query)
+    {
+        if (!bInFlight[Query])
+        {
+            return true;
+        }
+
+        GLint bAvailable = GL_FALSE;
+        glGetQueryObjectiv(Queries[Query], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+        if (bAvailable == GL_FALSE)
+        {
+            return false;
+        }
+
+        GLuint64 Nanoseconds = 0;
+        glGetQueryObjectui64v(Queries[Query], GL_QUERY_RESULT, &Nanoseconds);
+        Profiler::Get()->AddSample(Stage, StartTimes[Query], static_cast<double>(Nanoseconds) * 1e-9);
+        bInFlight[Query] = false;
+        return true;
+    }
+
+    void GPUTimer::Begin()
+    {
+        if (Queries[0] == 0)
+        {
+            return;
+        }
+
+        for (int i = 0; i < NumQueries; i++)
+        {
+            Collect((NextQuery + i) % NumQueries);
+        }
+
+        //skip timing rather than stall while the GPU is still behind on the query we'd reuse
+        if (bInFlight[NextQuery])
+        {
+            return;
+        }
+
+        ActiveQuery = NextQuery;
+        NextQuery = (NextQuery + 1) % NumQueries;
+        StartTimes[ActiveQuery] = Profiler::Get()->Now();
+        glBeginQuery(GL_TIME_ELAPSED, Queries[ActiveQuery]);
+    }
+
+    void GPUTimer::End()
+    {
+        if (ActiveQuery < 0)
+        {
+            return;
+        }
+
+        glEndQuery(GL_TIME_ELAPSED);
+        bInFlight[ActiveQuery] = true;
+        ActiveQuery = -1;
+    }
+}
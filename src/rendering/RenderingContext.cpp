@@ -3,23 +3,86 @@
 //
 
 #include "rendering/RenderingContext.h"
+#include <cstring>
 #include "glad/glad.h"
+#include "rendering/ShaderProgram.h"
 
 void Rendering::RenderingContext::Initialize()
 {
     glGenVertexArrays(1, &ActiveVAO);
     glBindVertexArray(ActiveVAO);
 
-    glGenBuffers(1, &LocationVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, LocationVBO);
-    //glBufferStorage(GL_ARRAY_BUFFER, sizeof(glm::vec3)*MaxVertices, nullptr, );
-
-    glGenBuffers(1, &ColorVBO);
-    glGenBuffers(1, &IndexBufferObject);
+    //every attribute reads from the one interleaved buffer, which is bound on the first upload
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
 
+    //the global uniform block stays bound to its binding point, each program's block is pointed at it when linked
     glGenBuffers(1, &UBO_Block);
-    glBindBuffer(GL_UNIFORM_BLOCK, UBO_Block);
-    //glBufferStorage(GL_UNIFORM_BLOCK, sizeof(GlobalUniforms), nullptr)
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO_Block);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(GlobalUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, ShaderProgram::GlobalUniformsBinding, UBO_Block);
+    bUniformsUploaded = false;
+}
+
+void Rendering::RenderingContext::Release()
+{
+    ModelVertices.Release();
+    if (ActiveVAO != 0)
+    {
+        glDeleteVertexArrays(1, &ActiveVAO);
+        ActiveVAO = 0;
+    }
+    if (UBO_Block != 0)
+    {
+        glDeleteBuffers(1, &UBO_Block);
+        UBO_Block = 0;
+    }
+}
+
+void Rendering::RenderingContext::UpdateGlobalUniforms(const GlobalUniforms& Uniforms)
+{
+    //most frames the camera and light haven't moved, and there is nothing to send
+    if (UBO_Block == 0 || (bUniformsUploaded && memcmp(&Uniforms, &UploadedUniforms, sizeof(GlobalUniforms)) == 0))
+    {
+        return;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO_Block);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(GlobalUniforms), &Uniforms);
+    UploadedUniforms = Uniforms;
+    bUniformsUploaded = true;
+}
+
+Rendering::VertexLayout* Rendering::RenderingContext::BeginModelUpload(const size_t NewNumVertices)
+{
+    NumVertices = static_cast<uint32_t>(NewNumVertices);
+    return static_cast<VertexLayout*>(ModelVertices.BeginWrite(NewNumVertices * sizeof(VertexLayout)));
+}
+
+bool Rendering::RenderingContext::EndModelUpload()
+{
+    if (!ModelVertices.EndWrite())
+    {
+        NumVertices = 0;
+        return false;
+    }
+
+    //the vertices move within the buffer from one upload to the next, so the attributes are re-pointed each time
+    glBindVertexArray(ActiveVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, ModelVertices.GetBuffer());
+
+    constexpr GLsizei Stride = sizeof(VertexLayout);
+    const size_t Base = ModelVertices.GetDrawOffset();
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, Stride, reinterpret_cast<void*>(Base + offsetof(VertexLayout, Location)));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, Stride, reinterpret_cast<void*>(Base + offsetof(VertexLayout, Color)));
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, Stride, reinterpret_cast<void*>(Base + offsetof(VertexLayout, Normals)));
+    return true;
+}
+
+void Rendering::RenderingContext::BindModel() const
+{
+    glBindVertexArray(ActiveVAO);
 }
 
 void Rendering::RenderingContext::SetActiveCamera(Camera *Camera)
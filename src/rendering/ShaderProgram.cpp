@@ -82,9 +82,42 @@ namespace Rendering {
             return false;
         }
 
+        CacheUniforms();
         return true;
     }
 
+    /** ShaderProgram::CacheUniforms
+     * points the program's global uniform block, if it declares one, at the shared binding point, and records the
+     * location of every other active uniform so they aren't looked up by name while rendering
+     */
+    void ShaderProgram::CacheUniforms()
+    {
+        const GLuint BlockIndex = glGetUniformBlockIndex(ProgramID, GlobalUniformsBlockName);
+        if (BlockIndex != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(ProgramID, BlockIndex, GlobalUniformsBinding);
+        }
+
+        UniformLocations.clear();
+        GLint NumUniforms = 0;
+        glGetProgramiv(ProgramID, GL_ACTIVE_UNIFORMS, &NumUniforms);
+        for (GLint i = 0; i < NumUniforms; i++)
+        {
+            char UniformName[256];
+            GLsizei NameLength = 0;
+            GLint ArraySize = 0;
+            GLenum Type = 0;
+            glGetActiveUniform(ProgramID, i, sizeof(UniformName), &NameLength, &ArraySize, &Type, UniformName);
+
+            //members of uniform blocks have no location, they're set through the block's buffer
+            const GLint Location = glGetUniformLocation(ProgramID, UniformName);
+            if (Location >= 0)
+            {
+                UniformLocations[UniformName] = Location;
+            }
+        }
+    }
+
     /*** ShaderProgram::CompileAttachedShaders
      * attempts to compile attached shaders
      * @return true if all attached shaderobjects were compiled successfully
@@ -126,4 +159,10 @@ namespace Rendering {
     {
         return ProgramID;
     }
+
+    int ShaderProgram::GetUniformLocation(const std::string& UniformName) const
+    {
+        const auto Found = UniformLocations.find(UniformName);
+        return Found != UniformLocations.end() ? Found->second : -1;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "rendering/StreamingBuffer.h"
+
+#include "glad/glad.h"
+#include "myc/logging/logging.h"
+#include "utility/Profiler.h"
+
+namespace Rendering
+{
+    StreamingBuffer::~StreamingBuffer()
+    {
+        Release();
+    }
+
+    void StreamingBuffer::Release()
+    {
+        for (GLsync& Fence : RegionFences)
+        {
+            if (Fence != nullptr)
+            {
+                glDeleteSync(Fence);
+                Fence = nullptr;
+            }
+        }
+
+        if (Buffer != 0)
+        {
+            if (PersistentMapping != nullptr)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+                PersistentMapping = nullptr;
+            }
+            glDeleteBuffers(1, &Buffer);
+            Buffer = 0;
+        }
+        RegionSize = 0;
+    }
+
+    bool StreamingBuffer::Allocate(const size_t Size)
+    {
+        //regions are sized to the request with a little headroom, so a model growing a little each regeneration
+        //doesn't recreate the buffer each time, without the buffer being far larger than the model
+        constexpr size_t Granularity = 64 * 1024;
+        const size_t WithHeadroom = Size + Size / HeadroomDivisor;
+        const size_t NewRegionSize = (WithHeadroom / Granularity + 1) * Granularity;
+
+        Release();
+        glGenBuffers(1, &Buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+
+        bPersistent = GLAD_GL_ARB_buffer_storage != 0;
+        if (bPersistent)
+        {
+            constexpr GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            const auto TotalSize = static_cast<GLsizeiptr>(NewRegionSize * NumRegions);
+            glBufferStorage(GL_ARRAY_BUFFER, TotalSize, nullptr, Flags);
+            PersistentMapping = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, TotalSize, Flags));
+            if (PersistentMapping == nullptr)
+            {
+                LogError("could not persistently map a streaming buffer of %zu bytes\n", NewRegionSize * NumRegions);
+                Release();
+                return false;
+            }
+        }
+
+        RegionSize = NewRegionSize;
+        WriteRegion = 0;
+        return true;
+    }
+
+    void* StreamingBuffer::BeginWrite(const size_t Size)
+    {
+        PROFILE_SCOPE("Buffer Map");
+
+        if (bWriting)
+        {
+            LogError("streaming buffer written again before the previous write ended\n");
+            return nullptr;
+        }
+
+        //the buffer is recreated when the data outgrows it, and when it shrinks so far that most of it would sit unused
+        if ((Buffer == 0 || Size > RegionSize || Size < RegionSize / 4) && !Allocate(Size))
+        {
+            return nullptr;
+        }
+
+        if (!bPersistent)
+        {
+            //orphan the old storage, whatever is still drawing from it keeps it until done
+            glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(RegionSize), nullptr, GL_STREAM_DRAW);
+            void* Mapping = glMapBufferRange(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(RegionSize),
+                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            bWriting = Mapping != nullptr;
+            return Mapping;
+        }
+
+        //the region was last drawn before it was written over by the other one, wait until those draws are done
+        GLsync& Fence = RegionFences[WriteRegion];
+        if (Fence != nullptr)
+        {
+            GLenum WaitResult = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            while (WaitResult == GL_TIMEOUT_EXPIRED)
+            {
+                WaitResult = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+            glDeleteSync(Fence);
+            Fence = nullptr;
+        }
+
+        bWriting = true;
+        return PersistentMapping + RegionSize * WriteRegion;
+    }
+
+    bool StreamingBuffer::EndWrite()
+    {
+        PROFILE_SCOPE("Buffer Unmap");
+
+        if (!bWriting)
+        {
+            return false;
+        }
+        bWriting = false;
+
+        if (!bPersistent)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+            DrawOffset = 0;
+            return glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+        }
+
+        //every draw of the region shown until now has been issued, fence them before it can be written again
+        const int ShownRegion = (WriteRegion + NumRegions - 1) % NumRegions;
+        if (RegionFences[ShownRegion] != nullptr)
+        {
+            glDeleteSync(RegionFences[ShownRegion]);
+        }
+        RegionFences[ShownRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        DrawOffset = RegionSize * WriteRegion;
+        WriteRegion = (WriteRegion + 1) % NumRegions;
+        return true;
+    }
+}
@@ -0,0 +1,144 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "rendering/Surface.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "myc/logging/logging.h"
+
+//resolves a 1-based, or negative relative, OBJ index into a 0-based one, -1 if it's out of range
+static int ResolveOBJIndex(const long Index, const size_t Count)
+{
+    const long Resolved = Index > 0 ? Index - 1 : static_cast<long>(Count) + Index;
+    return Resolved >= 0 && Resolved < static_cast<long>(Count) ? static_cast<int>(Resolved) : -1;
+}
+
+bool SurfaceMesh::LoadFromOBJ(const char* Filename)
+{
+    Positions.clear();
+    Normals.clear();
+
+    if (Filename == nullptr)
+    {
+        return false;
+    }
+
+    FILE* fp = fopen(Filename, "r");
+    if (fp == nullptr)
+    {
+        LogWarning("could not open surface %s\n", Filename);
+        return false;
+    }
+
+    std::vector<glm::vec3> FilePositions;
+    std::vector<glm::vec3> FileNormals;
+
+    char line[1024];
+    while (fgets(line, 1024, fp))
+    {
+        if (line[0] == 'v' && line[1] == ' ')
+        {
+            glm::vec3 Position(0.0f);
+            sscanf(line + 2, "%f %f %f", &Position.x, &Position.y, &Position.z);
+            FilePositions.push_back(Position);
+        }
+        else if (line[0] == 'v' && line[1] == 'n' && line[2] == ' ')
+        {
+            glm::vec3 Normal(0.0f);
+            sscanf(line + 3, "%f %f %f", &Normal.x, &Normal.y, &Normal.z);
+            FileNormals.push_back(Normal);
+        }
+        else if (line[0] == 'f' && line[1] == ' ')
+        {
+            //each vertex is v, v/vt, v//vn or v/vt/vn
+            int FacePositions[64];
+            int FaceNormals[64];
+            int NumVertices = 0;
+
+            char* Cursor = line + 2;
+            while (NumVertices < 64)
+            {
+                char* End = nullptr;
+                const long PositionIndex = strtol(Cursor, &End, 10);
+                if (End == Cursor)
+                {
+                    break;
+                }
+                Cursor = End;
+
+                long NormalIndex = 0;
+                if (*Cursor == '/')
+                {
+                    Cursor++;
+                    strtol(Cursor, &End, 10);
+                    Cursor = End;
+                    if (*Cursor == '/')
+                    {
+                        Cursor++;
+                        NormalIndex = strtol(Cursor, &End, 10);
+                        Cursor = End;
+                    }
+                }
+
+                FacePositions[NumVertices] = ResolveOBJIndex(PositionIndex, FilePositions.size());
+                FaceNormals[NumVertices] = NormalIndex != 0 ? ResolveOBJIndex(NormalIndex, FileNormals.size()) : -1;
+                if (FacePositions[NumVertices] < 0)
+                {
+                    LogWarning("surface %s references a missing vertex\n", Filename);
+                    NumVertices = 0;
+                    break;
+                }
+                NumVertices++;
+            }
+
+            //fan triangulate, surfaces are expected to be made of convex faces
+            for (int i = 1; i + 1 < NumVertices; i++)
+            {
+                const int Corners[3] = {0, i, i + 1};
+                const glm::vec3 FaceNormal = glm::cross(FilePositions[FacePositions[i]] - FilePositions[FacePositions[0]],
+                                                        FilePositions[FacePositions[i + 1]] - FilePositions[FacePositions[0]]);
+                for (const int Corner : Corners)
+                {
+                    Positions.push_back(FilePositions[FacePositions[Corner]]);
+                    Normals.push_back(FaceNormals[Corner] >= 0 ? FileNormals[FaceNormals[Corner]] : FaceNormal);
+                }
+            }
+        }
+    }
+
+    fclose(fp);
+
+    if (Positions.empty())
+    {
+        LogWarning("surface %s has no faces\n", Filename);
+        return false;
+    }
+    return true;
+}
+
+SurfaceMesh SurfaceMesh::BuiltInLeaf()
+{
+    //outline in units of the leaf's length, fanned around its first vertex
+    static const glm::vec3 Outline[] = {
+        {0.0f, 0.0f, 0.0f},
+        {0.22f, 0.18f, 0.0f},
+        {0.3f, 0.45f, 0.0f},
+        {0.0f, 1.0f, 0.0f},
+        {-0.3f, 0.45f, 0.0f},
+        {-0.22f, 0.18f, 0.0f},
+    };
+    constexpr int NumOutlineVertices = sizeof(Outline) / sizeof(Outline[0]);
+
+    SurfaceMesh Leaf;
+    for (int i = 1; i + 1 < NumOutlineVertices; i++)
+    {
+        Leaf.Positions.push_back(Outline[0]);
+        Leaf.Positions.push_back(Outline[i]);
+        Leaf.Positions.push_back(Outline[i + 1]);
+        Leaf.Normals.insert(Leaf.Normals.end(), 3, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+    return Leaf;
+}
@@ -0,0 +1,162 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "rendering/SurfaceLibrary.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include "glad/glad.h"
+#include "myc/logging/logging.h"
+
+Rendering::SurfaceLibrary* Rendering::SurfaceLibrary::sSurfaceLibrary = nullptr;
+
+namespace Rendering
+{
+    SurfaceLibrary* SurfaceLibrary::Get()
+    {
+        if (!sSurfaceLibrary)
+        {
+            sSurfaceLibrary = new SurfaceLibrary();
+        }
+        return sSurfaceLibrary;
+    }
+
+    void SurfaceLibrary::LoadFromDirectory(const std::string& Directory)
+    {
+        //the built in leaf is always available, in the slot no symbol names
+        CreateSurface(static_cast<char>(DefaultSurface), SurfaceMesh::BuiltInLeaf());
+
+        const std::string IndexFilename = Directory + "/surfaces";
+        FILE* fp = fopen(IndexFilename.c_str(), "r");
+        if (fp == nullptr)
+        {
+            LogWarning("no surface index at %s, only the built in leaf is available\n", IndexFilename.c_str());
+            return;
+        }
+
+        char line[1024];
+        while (fgets(line, 1024, fp))
+        {
+            //NAME:FILE, ignoring blank lines and comments
+            line[strcspn(line, "\r\n")] = '\0';
+            if (static_cast<unsigned char>(line[0]) <= 32 || line[0] == '#' || line[1] != ':')
+            {
+                continue;
+            }
+
+            const char Name = line[0];
+            if (static_cast<unsigned char>(Name) >= MaxSurfaces)
+            {
+                continue;
+            }
+
+            SurfaceMesh Mesh;
+            if (!Mesh.LoadFromOBJ((Directory + "/" + (line + 2)).c_str()))
+            {
+                continue;
+            }
+            if (!CreateSurface(Name, Mesh))
+            {
+                LogWarning("surface %c is defined more than once, keeping the first\n", Name);
+                continue;
+            }
+            LogInfo("loaded surface %c from %s, %d triangles\n", Name, line + 2, static_cast<int>(Mesh.Positions.size() / 3));
+        }
+
+        fclose(fp);
+    }
+
+    bool SurfaceLibrary::CreateSurface(const char Name, const SurfaceMesh& Mesh)
+    {
+        GPUSurface& Surface = Surfaces[static_cast<unsigned char>(Name)];
+        if (Surface.VAO != 0)
+        {
+            return false;
+        }
+
+        glGenVertexArrays(1, &Surface.VAO);
+        glBindVertexArray(Surface.VAO);
+
+        //mesh positions followed by normals, shared by every instance
+        const GLsizeiptr StreamSize = static_cast<GLsizeiptr>(Mesh.Positions.size() * sizeof(glm::vec3));
+        glGenBuffers(1, &Surface.MeshVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, Surface.MeshVBO);
+        glBufferData(GL_ARRAY_BUFFER, 2 * StreamSize, nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, StreamSize, Mesh.Positions.data());
+        glBufferSubData(GL_ARRAY_BUFFER, StreamSize, StreamSize, Mesh.Normals.data());
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void*>(StreamSize));
+        glEnableVertexAttribArray(2);
+
+        //per instance frame and color, advancing once per instance rather than per vertex
+        glGenBuffers(1, &Surface.InstanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, Surface.InstanceVBO);
+        constexpr GLsizei Stride = sizeof(SurfaceInstance);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, Stride, reinterpret_cast<void*>(offsetof(SurfaceInstance, Location)));
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, Stride, reinterpret_cast<void*>(offsetof(SurfaceInstance, Right)));
+        glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, Stride, reinterpret_cast<void*>(offsetof(SurfaceInstance, Up)));
+        glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, Stride, reinterpret_cast<void*>(offsetof(SurfaceInstance, Forward)));
+        glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, Stride, reinterpret_cast<void*>(offsetof(SurfaceInstance, Color)));
+        for (GLuint Attribute = 3; Attribute <= 7; Attribute++)
+        {
+            glEnableVertexAttribArray(Attribute);
+            glVertexAttribDivisor(Attribute, 1);
+        }
+
+        Surface.NumVertices = static_cast<int>(Mesh.Positions.size());
+        return true;
+    }
+
+    void SurfaceLibrary::UploadInstances(const std::vector<SurfaceInstance>* Instances, const glm::vec3& Offset)
+    {
+        NumInstances = 0;
+
+        //instances of surfaces without a mesh are gathered up and drawn as the default surface
+        DefaultInstances.clear();
+        for (int Name = 0; Name < MaxSurfaces; Name++)
+        {
+            if (Surfaces[Name].VAO == 0 || Name == DefaultSurface)
+            {
+                DefaultInstances.insert(DefaultInstances.end(), Instances[Name].begin(), Instances[Name].end());
+            }
+        }
+
+        for (int Name = 0; Name < MaxSurfaces; Name++)
+        {
+            GPUSurface& Surface = Surfaces[Name];
+            if (Surface.VAO == 0)
+            {
+                continue;
+            }
+
+            const std::vector<SurfaceInstance>& Source = Name == DefaultSurface ? DefaultInstances : Instances[Name];
+            ShiftedInstances.assign(Source.begin(), Source.end());
+            for (SurfaceInstance& Instance : ShiftedInstances)
+            {
+                Instance.Location += Offset;
+            }
+
+            glBindBuffer(GL_ARRAY_BUFFER, Surface.InstanceVBO);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(ShiftedInstances.size() * sizeof(SurfaceInstance)), ShiftedInstances.data(), GL_STATIC_DRAW);
+            Surface.NumInstances = static_cast<int>(ShiftedInstances.size());
+            NumInstances += ShiftedInstances.size();
+        }
+    }
+
+    void SurfaceLibrary::Draw() const
+    {
+        for (const GPUSurface& Surface : Surfaces)
+        {
+            if (Surface.VAO == 0 || Surface.NumInstances == 0)
+            {
+                continue;
+            }
+
+            glBindVertexArray(Surface.VAO);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, Surface.NumVertices, Surface.NumInstances);
+        }
+    }
+}
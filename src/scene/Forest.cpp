@@ -0,0 +1,274 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "scene/Forest.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include "glad/glad.h"
+#include "myc/logging/logging.h"
+#include "lindenmayer/lindenmayer.h"
+#include "rendering/RenderingContext.h"
+#include "utility/Random.h"
+
+namespace Scene
+{
+    //uniform float in [0, 1) from 64 random bits
+    static float UnitFloat(const uint64_t Bits)
+    {
+        return static_cast<float>(Bits >> 40) / static_cast<float>(1 << 24);
+    }
+
+    void Forest::Release()
+    {
+        for (Species& Plant : AllSpecies)
+        {
+            if (Plant.VAO != 0)
+            {
+                glDeleteVertexArrays(1, &Plant.VAO);
+                glDeleteBuffers(1, &Plant.MeshVBO);
+                glDeleteBuffers(1, &Plant.InstanceVBO);
+            }
+            Plant = Species();
+        }
+        for (std::vector<SurfaceInstance>& Instances : SurfaceInstances)
+        {
+            Instances.clear();
+        }
+        NumSpecies = 0;
+        NumPlants = 0;
+    }
+
+    void Forest::Clear()
+    {
+        Release();
+    }
+
+    int Forest::AddSpecies(const std::shared_ptr<const GeneratedModel>& Generated, const float Weight)
+    {
+        if (Generated == nullptr)
+        {
+            return -1;
+        }
+
+        //plants of a model already in the forest join its species
+        for (int i = 0; i < NumSpecies; i++)
+        {
+            if (AllSpecies[i].Model->Hash == Generated->Hash)
+            {
+                AllSpecies[i].Weight += Weight;
+                return i;
+            }
+        }
+
+        if (NumSpecies >= MaxSpecies)
+        {
+            LogWarning("a forest holds at most %d species\n", MaxSpecies);
+            return -1;
+        }
+
+        const ColoredTriangleList& Model = Generated->Triangles;
+        const size_t NumVertices = static_cast<size_t>(Model.NumTriangles) * 3;
+        if (NumVertices == 0)
+        {
+            return -1;
+        }
+
+        Species& NewSpecies = AllSpecies[NumSpecies];
+        glGenVertexArrays(1, &NewSpecies.VAO);
+        glBindVertexArray(NewSpecies.VAO);
+
+        //the model's vertices, interleaved as the single model is, written straight into the new buffer
+        glGenBuffers(1, &NewSpecies.MeshVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, NewSpecies.MeshVBO);
+        const auto BufferSize = static_cast<GLsizeiptr>(NumVertices * sizeof(Rendering::VertexLayout));
+        glBufferData(GL_ARRAY_BUFFER, BufferSize, nullptr, GL_STATIC_DRAW);
+        auto* Vertices = static_cast<Rendering::VertexLayout*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, BufferSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (Vertices != nullptr)
+        {
+            for (long long TriangleIndex = 0; TriangleIndex < Model.NumTriangles; TriangleIndex++)
+            {
+                const ColoredTriangle& Triangle = Model.TriData[TriangleIndex];
+                for (int VertIndex = 0; VertIndex < 3; VertIndex++)
+                {
+                    Rendering::VertexLayout& Vertex = Vertices[TriangleIndex * 3 + VertIndex];
+                    Vertex.Location = Triangle.VertexLocations[VertIndex];
+                    Vertex.Color = Triangle.VertexColors[VertIndex];
+                    Vertex.Normals = Triangle.VertexNormals[VertIndex];
+                }
+            }
+        }
+        if (Vertices == nullptr || glUnmapBuffer(GL_ARRAY_BUFFER) != GL_TRUE)
+        {
+            LogError("could not write the vertices of a forest species\n");
+            glDeleteVertexArrays(1, &NewSpecies.VAO);
+            glDeleteBuffers(1, &NewSpecies.MeshVBO);
+            NewSpecies = Species();
+            return -1;
+        }
+
+        constexpr GLsizei VertexStride = sizeof(Rendering::VertexLayout);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VertexStride, reinterpret_cast<void*>(offsetof(Rendering::VertexLayout, Location)));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VertexStride, reinterpret_cast<void*>(offsetof(Rendering::VertexLayout, Color)));
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VertexStride, reinterpret_cast<void*>(offsetof(Rendering::VertexLayout, Normals)));
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+
+        //per plant placement and tint, advancing once per instance rather than per vertex
+        glGenBuffers(1, &NewSpecies.InstanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, NewSpecies.InstanceVBO);
+        constexpr GLsizei InstanceStride = sizeof(PlantInstance);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, InstanceStride, reinterpret_cast<void*>(offsetof(PlantInstance, Location)));
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, InstanceStride, reinterpret_cast<void*>(offsetof(PlantInstance, Tint)));
+        for (GLuint Attribute = 3; Attribute <= 4; Attribute++)
+        {
+            glEnableVertexAttribArray(Attribute);
+            glVertexAttribDivisor(Attribute, 1);
+        }
+
+        NewSpecies.NumOneSidedVertices = static_cast<int>(Model.FirstTwoSidedTriangle * 3);
+        NewSpecies.NumTwoSidedVertices = static_cast<int>(NumVertices) - NewSpecies.NumOneSidedVertices;
+        NewSpecies.Model = Generated;
+        NewSpecies.Weight = Weight;
+        LogInfo("added forest species %d, %lld triangles\n", NumSpecies, Model.NumTriangles);
+        return NumSpecies++;
+    }
+
+    void Forest::Scatter(const int NewNumPlants, const float Radius, const uint32_t Seed)
+    {
+        NumPlants = 0;
+        for (std::vector<SurfaceInstance>& Instances : SurfaceInstances)
+        {
+            Instances.clear();
+        }
+        if (NumSpecies == 0)
+        {
+            return;
+        }
+
+        float TotalWeight = 0.0f;
+        for (int i = 0; i < NumSpecies; i++)
+        {
+            SpeciesPlants[i].clear();
+            TotalWeight += AllSpecies[i].Weight;
+        }
+
+        for (int PlantIndex = 0; PlantIndex < NewNumPlants; PlantIndex++)
+        {
+            //every property of a plant comes from its own seed, so changing the count keeps the plants already placed
+            const auto PlantSeed = static_cast<uint32_t>(CounterRandom(Seed, 0, PlantIndex));
+            const float Distance = Radius * sqrtf(UnitFloat(CounterRandom(PlantSeed, 0, 0)));
+            const float Direction = 2.0f * static_cast<float>(M_PI) * UnitFloat(CounterRandom(PlantSeed, 0, 1));
+
+            PlantInstance Plant;
+            Plant.Location = glm::vec3(Distance * cosf(Direction), 0.0f, Distance * sinf(Direction));
+            Plant.Scale = 0.75f + 0.5f * UnitFloat(CounterRandom(PlantSeed, 0, 2));
+            Plant.Yaw = 2.0f * static_cast<float>(M_PI) * UnitFloat(CounterRandom(PlantSeed, 0, 3));
+            for (int Channel = 0; Channel < 3; Channel++)
+            {
+                Plant.Tint[Channel] = 0.85f + 0.3f * UnitFloat(CounterRandom(PlantSeed, 1, Channel));
+            }
+            Plant.Seed = PlantSeed;
+
+            //plants are dealt out to species in proportion to their weights, which places exactly the counts a scene
+            //asks for when there are as many plants as its total weight. Their locations are random, so the species
+            //still mix
+            const float Share = (static_cast<float>(PlantIndex) + 0.5f) * TotalWeight / static_cast<float>(NewNumPlants);
+            int SpeciesIndex = 0;
+            for (float Cumulative = AllSpecies[0].Weight; Share >= Cumulative && SpeciesIndex + 1 < NumSpecies; Cumulative += AllSpecies[SpeciesIndex].Weight)
+            {
+                SpeciesIndex++;
+            }
+            SpeciesPlants[SpeciesIndex].push_back(Plant);
+        }
+
+        for (int i = 0; i < NumSpecies; i++)
+        {
+            Species& Plants = AllSpecies[i];
+            glBindBuffer(GL_ARRAY_BUFFER, Plants.InstanceVBO);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(SpeciesPlants[i].size() * sizeof(PlantInstance)), SpeciesPlants[i].data(), GL_STATIC_DRAW);
+            Plants.NumPlants = static_cast<int>(SpeciesPlants[i].size());
+            NumPlants += SpeciesPlants[i].size();
+
+            //surfaces are drawn per placement rather than per plant, so each plant's placement is applied to them
+            //here, as the forest shader applies it to the plant's vertices
+            for (const PlantInstance& Plant : SpeciesPlants[i])
+            {
+                const float c = cosf(Plant.Yaw);
+                const float s = sinf(Plant.Yaw);
+                const glm::mat3 Yaw(c, 0.0f, -s,
+                                    0.0f, 1.0f, 0.0f,
+                                    s, 0.0f, c);
+                for (int Name = 0; Name < 128; Name++)
+                {
+                    for (const SurfaceInstance& Surface : Plants.Model->SurfaceInstances[Name])
+                    {
+                        SurfaceInstances[Name].push_back({Plant.Location + Yaw * (Surface.Location * Plant.Scale),
+                                                          Surface.Scale * Plant.Scale, Yaw * Surface.Right,
+                                                          Yaw * Surface.Up, Yaw * Surface.Forward,
+                                                          Surface.Color * Plant.Tint});
+                    }
+                }
+            }
+        }
+    }
+
+    int Forest::LoadFromFile(const char* Filename)
+    {
+        FILE* fp = fopen(Filename, "r");
+        if (fp == nullptr)
+        {
+            LogError("could not open scene %s\n", Filename);
+            return -1;
+        }
+
+        //system files are named relative to the scene
+        const std::string SceneFilename(Filename);
+        const size_t Separator = SceneFilename.find_last_of("/\\");
+        const std::string Directory = Separator == std::string::npos ? std::string() : SceneFilename.substr(0, Separator + 1);
+
+        int TotalPlants = 0;
+        char Line[512];
+        while (fgets(Line, sizeof(Line), fp) != nullptr)
+        {
+            char SystemFilename[400];
+            int Count = 1;
+            if (Line[0] == '#' || sscanf(Line, "%399s %d", SystemFilename, &Count) < 1 || Count <= 0)
+            {
+                continue;
+            }
+
+            const std::string SystemPath = SystemFilename[0] == '/' ? std::string(SystemFilename) : Directory + SystemFilename;
+            LSystem System;
+            System.LoadFromFile(SystemPath.c_str());
+            if (AddSpecies(GenerationCache::Get()->Acquire(System), static_cast<float>(Count)) >= 0)
+            {
+                TotalPlants += Count;
+            }
+        }
+
+        fclose(fp);
+        LogInfo("loaded scene %s, %d plants of %d species\n", Filename, TotalPlants, NumSpecies);
+        return TotalPlants;
+    }
+
+    void Forest::Draw(const bool bTwoSided) const
+    {
+        for (int i = 0; i < NumSpecies; i++)
+        {
+            const Species& Plants = AllSpecies[i];
+            const int NumVertices = bTwoSided ? Plants.NumTwoSidedVertices : Plants.NumOneSidedVertices;
+            if (Plants.NumPlants == 0 || NumVertices == 0)
+            {
+                continue;
+            }
+
+            glBindVertexArray(Plants.VAO);
+            glDrawArraysInstanced(GL_TRIANGLES, bTwoSided ? Plants.NumOneSidedVertices : 0, NumVertices, Plants.NumPlants);
+        }
+    }
+}
@@ -0,0 +1,117 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "scene/GenerationCache.h"
+
+#include <cstring>
+#include "myc/logging/logging.h"
+#include "lindenmayer/lindenmayer.h"
+#include "utility/Turtle.h"
+
+Scene::GenerationCache* Scene::GenerationCache::sGenerationCache = nullptr;
+
+namespace Scene
+{
+    GenerationCache* GenerationCache::Get()
+    {
+        if (!sGenerationCache)
+        {
+            sGenerationCache = new GenerationCache();
+        }
+        return sGenerationCache;
+    }
+
+    GenerationCache::GenerationCache()
+    {
+        Generator = new Turtle();
+    }
+
+    GenerationCache::~GenerationCache()
+    {
+        delete Generator;
+        delete Scratch;
+    }
+
+    std::shared_ptr<const GeneratedModel> GenerationCache::Acquire(LSystem& System)
+    {
+        const uint64_t Hash = System.GetContentHash();
+
+        const auto Found = Entries.find(Hash);
+        if (Found != Entries.end())
+        {
+            NumHits++;
+            RecentlyUsed.splice(RecentlyUsed.begin(), RecentlyUsed, Found->second.Use);
+            return Found->second.Model;
+        }
+        NumMisses++;
+
+        Generator->Reset();
+        System.Reset();
+        System.Rewrite();
+        Generator->DrawSystem(System, &Scratch);
+        if (Scratch == nullptr)
+        {
+            return nullptr;
+        }
+
+        //copy the drawing out of the full sized scratch list, which stays around for the next generation
+        auto Model = std::make_shared<GeneratedModel>(Scratch->NumTriangles);
+        Model->Hash = Hash;
+        if (Scratch->NumTriangles > 0)
+        {
+            memcpy(Model->Triangles.TriData, Scratch->TriData, Scratch->NumTriangles * sizeof(ColoredTriangle));
+        }
+        Model->Triangles.NumTriangles = Scratch->NumTriangles;
+        Model->Triangles.FirstTwoSidedTriangle = Scratch->FirstTwoSidedTriangle;
+        Model->Triangles.BoundingBoxMin = Scratch->BoundingBoxMin;
+        Model->Triangles.BoundingBoxMax = Scratch->BoundingBoxMax;
+        Model->Segments = Generator->Segments;
+        Model->Bytes = sizeof(GeneratedModel) + Scratch->NumTriangles * sizeof(ColoredTriangle) + Model->Segments.size() * sizeof(ConeSegment);
+        for (int i = 0; i < 128; i++)
+        {
+            Model->SurfaceInstances[i] = Generator->SurfaceInstances[i];
+            Model->Bytes += Model->SurfaceInstances[i].size() * sizeof(SurfaceInstance);
+        }
+
+        //make room before adding the model, so the budget holds the new model too
+        Trim(MemoryBudget > Model->Bytes ? MemoryBudget - Model->Bytes : 0);
+
+        RecentlyUsed.push_front(Hash);
+        Entries[Hash] = Entry{Model, RecentlyUsed.begin()};
+        MemoryUsed += Model->Bytes;
+        LogInfo("generated system %016llx, %lld triangles, %zu cached models\n", static_cast<unsigned long long>(Hash), Model->Triangles.NumTriangles, Entries.size());
+
+        return Model;
+    }
+
+    void GenerationCache::SetMemoryBudget(const size_t Bytes)
+    {
+        MemoryBudget = Bytes;
+        Trim(MemoryBudget);
+    }
+
+    void GenerationCache::Clear()
+    {
+        Trim(0);
+    }
+
+    void GenerationCache::Trim(const size_t Budget)
+    {
+        //models still held elsewhere stay, dropping them would free nothing and only lose the sharing
+        auto Use = RecentlyUsed.end();
+        while (MemoryUsed > Budget && Use != RecentlyUsed.begin())
+        {
+            --Use;
+            const auto Found = Entries.find(*Use);
+            if (Found->second.Model.use_count() > 1)
+            {
+                continue;
+            }
+
+            MemoryUsed -= Found->second.Model->Bytes;
+            Entries.erase(Found);
+            Use = RecentlyUsed.erase(Use);
+        }
+    }
+}
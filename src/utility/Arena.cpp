@@ -0,0 +1,108 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "utility/Arena.h"
+
+#include <cstdlib>
+#include "myc/logging/logging.h"
+
+//usable memory of a block starts right after its header
+static unsigned char* BlockData(void* Header, const size_t HeaderSize)
+{
+    return static_cast<unsigned char*>(Header) + HeaderSize;
+}
+
+Arena::Arena(const size_t InitialBlockSize)
+    : NextBlockSize(InitialBlockSize > 0 ? InitialBlockSize : 4096)
+{
+}
+
+Arena::~Arena()
+{
+    while (CurrentBlock != nullptr)
+    {
+        Block* Previous = CurrentBlock->Previous;
+        free(CurrentBlock);
+        CurrentBlock = Previous;
+    }
+}
+
+bool Arena::AddBlock(const size_t Size, const size_t Alignment)
+{
+    //grow geometrically, but always fit the allocation that triggered the new block
+    size_t BlockSize = NextBlockSize;
+    while (BlockSize < Size + Alignment)
+    {
+        BlockSize *= 2;
+    }
+
+    auto* NewBlock = static_cast<Block*>(malloc(sizeof(Block) + BlockSize));
+    if (NewBlock == nullptr)
+    {
+        LogError("arena could not allocate a block of %zu bytes\n", BlockSize);
+        return false;
+    }
+
+    NewBlock->Previous = CurrentBlock;
+    NewBlock->Size = BlockSize;
+    NewBlock->Used = 0;
+    CurrentBlock = NewBlock;
+    NextBlockSize = BlockSize * 2;
+    BytesReserved += BlockSize;
+    return true;
+}
+
+void* Arena::Allocate(const size_t Size, const size_t Alignment)
+{
+    for (int Attempt = 0; Attempt < 2; Attempt++)
+    {
+        if (CurrentBlock != nullptr)
+        {
+            unsigned char* Data = BlockData(CurrentBlock, sizeof(Block));
+            const uintptr_t Address = reinterpret_cast<uintptr_t>(Data + CurrentBlock->Used);
+            const uintptr_t Aligned = (Address + Alignment - 1) & ~static_cast<uintptr_t>(Alignment - 1);
+            const size_t NewUsed = static_cast<size_t>(Aligned - reinterpret_cast<uintptr_t>(Data)) + Size;
+            if (NewUsed <= CurrentBlock->Size)
+            {
+                BytesUsed += NewUsed - CurrentBlock->Used;
+                CurrentBlock->Used = NewUsed;
+                return reinterpret_cast<void*>(Aligned);
+            }
+        }
+
+        if (Attempt == 0 && !AddBlock(Size, Alignment))
+        {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+void Arena::Reset()
+{
+    if (CurrentBlock == nullptr)
+    {
+        return;
+    }
+
+    //the current block is always the largest, keep it and release the rest
+    Block* Previous = CurrentBlock->Previous;
+    while (Previous != nullptr)
+    {
+        Block* Next = Previous->Previous;
+        BytesReserved -= Previous->Size;
+        free(Previous);
+        Previous = Next;
+    }
+
+    CurrentBlock->Previous = nullptr;
+    CurrentBlock->Used = 0;
+    BytesUsed = 0;
+}
+
+Arena& Arena::GetThreadArena()
+{
+    static thread_local Arena ThreadArena;
+    return ThreadArena;
+}
@@ -0,0 +1,138 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "utility/Profiler.h"
+
+#include <cstdio>
+#include <cstring>
+
+Profiler* Profiler::sProfiler = nullptr;
+
+Profiler* Profiler::Get()
+{
+    if (!sProfiler)
+    {
+        sProfiler = new Profiler();
+    }
+    return sProfiler;
+}
+
+Profiler::Profiler()
+{
+    Epoch = std::chrono::steady_clock::now();
+}
+
+double Profiler::Now() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - Epoch).count();
+}
+
+int Profiler::RegisterStage(const char* Name, const bool bGPU)
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    for (int i = 0; i < NumStages; i++)
+    {
+        if (strcmp(Stages[i].Name, Name) == 0 && Stages[i].bGPU == bGPU)
+        {
+            return i;
+        }
+    }
+
+    if (NumStages >= MaxStages)
+    {
+        return -1;
+    }
+
+    Stages[NumStages].Name = Name;
+    Stages[NumStages].bGPU = bGPU;
+    return NumStages++;
+}
+
+uint32_t Profiler::GetThreadNumber(const std::thread::id Thread)
+{
+    for (size_t i = 0; i < Threads.size(); i++)
+    {
+        if (Threads[i] == Thread)
+        {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    Threads.push_back(Thread);
+    return static_cast<uint32_t>(Threads.size() - 1);
+}
+
+void Profiler::AddSample(const int Stage, const double Start, const double Duration)
+{
+    if (Stage < 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> Guard(Lock);
+    Stages[Stage].FrameTotal += Duration * 1000.0;
+
+    if (bCapturing && TraceEvents.size() < MaxTraceEvents)
+    {
+        //gpu stages get a track of their own, rather than the thread that read their queries
+        const uint32_t Thread = Stages[Stage].bGPU ? UINT32_MAX : GetThreadNumber(std::this_thread::get_id());
+        TraceEvents.push_back({Stage, Thread, Start, Duration});
+    }
+}
+
+void Profiler::EndFrame()
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    for (int i = 0; i < NumStages; i++)
+    {
+        Stages[i].History[HistoryPosition] = static_cast<float>(Stages[i].FrameTotal);
+        Stages[i].FrameTotal = 0.0;
+    }
+    HistoryPosition = (HistoryPosition + 1) % HistoryLength;
+}
+
+float Profiler::GetLastFrameTime(const int Stage) const
+{
+    return Stages[Stage].History[(HistoryPosition + HistoryLength - 1) % HistoryLength];
+}
+
+void Profiler::StartCapture()
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    TraceEvents.clear();
+    bCapturing = true;
+}
+
+void Profiler::StopCapture()
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    bCapturing = false;
+}
+
+bool Profiler::WriteChromeTrace(const char* Filename) const
+{
+    FILE* fp = fopen(Filename, "w");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> Guard(Lock);
+
+    //complete events, in microseconds, on one process with a track per thread and one for the gpu
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}", UINT32_MAX);
+    for (size_t i = 0; i < Threads.size(); i++)
+    {
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}", i, i == 0 ? "Main" : "Worker");
+    }
+    for (const TraceEvent& Event : TraceEvents)
+    {
+        fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                Stages[Event.Stage].Name, Stages[Event.Stage].bGPU ? "gpu" : "cpu", Event.Thread, Event.Start * 1e6, Event.Duration * 1e6);
+    }
+    fprintf(fp, "\n]}\n");
+
+    fclose(fp);
+    return true;
+}
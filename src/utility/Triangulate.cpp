@@ -0,0 +1,127 @@
+//
+// Created by Ryan on 10/19/2026.
+//
+
+#include "utility/Triangulate.h"
+
+#include <cmath>
+
+//twice the signed area of triangle abc, positive when counterclockwise
+static float SignedArea(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+//whether p lies inside or on counterclockwise triangle abc
+static bool IsInTriangle(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b, const glm::vec2& c)
+{
+    return SignedArea(a, b, p) >= 0.0f && SignedArea(b, c, p) >= 0.0f && SignedArea(c, a, p) >= 0.0f;
+}
+
+bool TriangulatePolygon(const glm::vec3* Vertices, const size_t NumVertices, std::vector<uint32_t>& Indices, glm::vec3& Normal, TriangulationScratch& Scratch)
+{
+    Indices.clear();
+    Normal = glm::vec3(0.0f);
+    if (NumVertices < 3)
+    {
+        return false;
+    }
+
+    //Newell's method, robust to concave and slightly non-planar polygons
+    for (size_t i = 0; i < NumVertices; i++)
+    {
+        const glm::vec3& Current = Vertices[i];
+        const glm::vec3& Next = Vertices[(i + 1) % NumVertices];
+        Normal.x += (Current.y - Next.y) * (Current.z + Next.z);
+        Normal.y += (Current.z - Next.z) * (Current.x + Next.x);
+        Normal.z += (Current.x - Next.x) * (Current.y + Next.y);
+    }
+    const float NormalLength = glm::length(Normal);
+    if (NormalLength <= 1e-12f)
+    {
+        return false;
+    }
+    Normal /= NormalLength;
+
+    //project into the plane with a right-handed basis, so the polygon winds counterclockwise in 2D
+    const glm::vec3 Reference = fabsf(Normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    const glm::vec3 U = glm::normalize(glm::cross(Reference, Normal));
+    const glm::vec3 V = glm::cross(Normal, U);
+
+    //remaining polygon as a doubly linked ring over the deduplicated vertices
+    std::vector<glm::vec2>& Projected = Scratch.Projected;
+    std::vector<uint32_t>& Original = Scratch.Original;
+    Projected.clear();
+    Original.clear();
+    for (size_t i = 0; i < NumVertices; i++)
+    {
+        const glm::vec2 Point(glm::dot(Vertices[i], U), glm::dot(Vertices[i], V));
+        if (!Projected.empty() && glm::dot(Point - Projected.back(), Point - Projected.back()) <= 1e-14f)
+        {
+            continue;
+        }
+        Projected.push_back(Point);
+        Original.push_back(static_cast<uint32_t>(i));
+    }
+    while (Projected.size() > 1 && glm::dot(Projected.front() - Projected.back(), Projected.front() - Projected.back()) <= 1e-14f)
+    {
+        Projected.pop_back();
+        Original.pop_back();
+    }
+
+    const size_t Count = Projected.size();
+    if (Count < 3)
+    {
+        return false;
+    }
+
+    std::vector<uint32_t>& Previous = Scratch.Previous;
+    std::vector<uint32_t>& Next = Scratch.Next;
+    Previous.resize(Count);
+    Next.resize(Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        Previous[i] = static_cast<uint32_t>((i + Count - 1) % Count);
+        Next[i] = static_cast<uint32_t>((i + 1) % Count);
+    }
+    Indices.reserve((Count - 2) * 3);
+
+    size_t Remaining = Count;
+    uint32_t Current = 0;
+    size_t Attempts = 0;
+    while (Remaining > 3)
+    {
+        const uint32_t a = Previous[Current], b = Current, c = Next[Current];
+
+        //an ear is a convex corner whose triangle holds no other remaining vertex. If a full pass finds none, the
+        //polygon isn't simple, so the corner is clipped anyway to guarantee progress
+        bool bIsEar = SignedArea(Projected[a], Projected[b], Projected[c]) > 0.0f;
+        for (uint32_t p = Next[c]; bIsEar && p != a; p = Next[p])
+        {
+            bIsEar = !IsInTriangle(Projected[p], Projected[a], Projected[b], Projected[c]);
+        }
+
+        if (bIsEar || Attempts >= Remaining)
+        {
+            Indices.push_back(Original[a]);
+            Indices.push_back(Original[b]);
+            Indices.push_back(Original[c]);
+
+            Next[a] = c;
+            Previous[c] = a;
+            Remaining--;
+            Attempts = 0;
+            Current = a;
+        }
+        else
+        {
+            Current = c;
+            Attempts++;
+        }
+    }
+
+    Indices.push_back(Original[Previous[Current]]);
+    Indices.push_back(Original[Current]);
+    Indices.push_back(Original[Next[Current]]);
+    return true;
+}
@@ -3,52 +3,153 @@
 //
 
 #include "utility/Turtle.h"
+#include "utility/Triangulate.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <cstring>
 #include <myc/logging/logging.h>
 #include <utility/util.h>
+#include "utility/Profiler.h"
+
+/* TurtleOpTable
+ * Maps every symbol to the turtle operation it performs, built at compile time
+ */
+struct TurtleOpTable
+{
+    ETurtleOp Ops[256];
+
+    constexpr TurtleOpTable() : Ops()
+    {
+        Ops['F'] = ETurtleOp::DrawForward;
+        Ops['G'] = ETurtleOp::DrawForwardNoRecord;
+        Ops['f'] = ETurtleOp::MoveForward;
+        Ops['+'] = ETurtleOp::YawLeft;
+        Ops['-'] = ETurtleOp::YawRight;
+        Ops['^'] = ETurtleOp::PitchUp;
+        Ops['&'] = ETurtleOp::PitchDown;
+        Ops['\\'] = ETurtleOp::RollLeft;
+        Ops['/'] = ETurtleOp::RollRight;
+        Ops['|'] = ETurtleOp::TurnAround;
+        Ops['$'] = ETurtleOp::RotateToVertical;
+        Ops['['] = ETurtleOp::StartBranch;
+        Ops[']'] = ETurtleOp::CompleteBranch;
+        Ops['%'] = ETurtleOp::CutOffBranch;
+        Ops['{'] = ETurtleOp::StartPolygon;
+        Ops['.'] = ETurtleOp::RecordVertex;
+        Ops['}'] = ETurtleOp::CompletePolygon;
+        Ops['~'] = ETurtleOp::PredefinedSurface;
+        Ops['!'] = ETurtleOp::DecrementWidth;
+        Ops['\''] = ETurtleOp::IncrementColorIndex;
+        Ops['`'] = ETurtleOp::IncrementColorIndex;
+    }
+};
+static constexpr TurtleOpTable TurtleOps;
+
+//HSV colors stepped through by the color index, from bark to foliage. The last color is kept once reached
+static const glm::vec3 ColorIndexPalette[] = {
+    {26.3f, 0.7f, 0.315f},
+    {32.0f, 0.65f, 0.33f},
+    {45.0f, 0.6f, 0.35f},
+    {70.0f, 0.6f, 0.35f},
+    {95.0f, 0.65f, 0.33f},
+    {115.0f, 0.7f, 0.3f},
+    {130.0f, 0.75f, 0.26f},
+    {145.0f, 0.8f, 0.22f},
+};
+static constexpr int ColorIndexPaletteSize = sizeof(ColorIndexPalette) / sizeof(ColorIndexPalette[0]);
+
+//degrees the hue advances per segment, so it comes back around after HueStepsPerTurn segments
+static constexpr int HueStepDegrees = 8;
+static constexpr int HueStepsPerTurn = 360 / HueStepDegrees;
+static_assert(360 % HueStepDegrees == 0, "the hue has to come back around to the palette color");
+
+/* HuePaletteTable
+ * Every color the turtle can draw with, each palette color at each hue step, converted to RGB once. Segments then
+ * look their color up by palette and hue step rather than stepping the hue through an RGB to HSV and back per segment
+ */
+struct HuePaletteTable
+{
+    glm::vec3 Colors[ColorIndexPaletteSize][HueStepsPerTurn];
+
+    HuePaletteTable()
+    {
+        for (int Index = 0; Index < ColorIndexPaletteSize; Index++)
+        {
+            for (int Step = 0; Step < HueStepsPerTurn; Step++)
+            {
+                glm::vec3 HSVColor = ColorIndexPalette[Index];
+                HSVColor.r = fmodf(HSVColor.r + static_cast<float>(Step * HueStepDegrees), 360.0f);
+                Colors[Index][Step] = HSVtoRGB(HSVColor);
+            }
+        }
+    }
+};
+static const HuePaletteTable HuePalette;
+
+//ratio applied to the segment width by '!'
+static constexpr float WidthDecrementRatio = 0.7f;
+static constexpr float MinimumWidth = 0.005f;
 
 void Turtle::Reset()
 {
-    CurrentTransform.Reset();
+    CurrentFrame.Reset();
+    bIsDefiningPolygon = false;
+    PolygonDepth = 0;
+    ColorIndex = 0;
+    HueStep = 0;
+    CurrentBranchStart = -1;
+    BranchStack.Clear();
 }
 
-void Turtle::MoveForward(float Distance)
+void Turtle::MoveForward(float Distance, bool bRecordVertex)
 {
     if(bIsDefiningPolygon)
     {
-        CurrentTransform.SetLocation(CurrentTransform.GetLocation() + CurrentTransform.GetForwardVector() * (Distance-CurrentWidth));
-        polygonVertices.push_back(CurrentTransform.GetLocation());
+        CurrentFrame.Location += CurrentFrame.GetForwardVector() * (Distance-CurrentWidth);
+        if(bRecordVertex)
+        {
+            RecordVertex();
+        }
     }
     else
     {
-        CurrentTransform.SetLocation(CurrentTransform.GetLocation() + CurrentTransform.GetForwardVector() * Distance);
+        CurrentFrame.Location += CurrentFrame.GetForwardVector() * Distance;
     }
 }
 
 void Turtle::DrawSystem(LSystem& System, ColoredTriangleList** List)
 {
-    //set starting HSV color, at set to current color
-    glm::vec3 CurrentHSVColor = {26.3, 0.7, .315};
-    CurrentColor = HSVtoRGB(CurrentHSVColor);
+    PROFILE_SCOPE("DrawSystem");
 
-    //set current width and how much to decrement when extending via 'F'
-    CurrentWidth = System.Distance / 3.141592f;
-    const float WidthDecrement = CurrentWidth / (3.141592f * 3.141592f * 3.141592f);
+    //start from the first palette color
+    ColorIndex = 0;
+    HueStep = 0;
+    CurrentBranchStart = -1;
+    UpdateColor();
 
-    //set source string based on whether we're working off a generated string or the axiom
-    const char* SourceString = System.GeneratedString != nullptr
-                                   ? System.GeneratedString
-                                   : System.Axiom;
+    //set current width, segments drawn via 'F' then narrow by a fixed decrement
+    CurrentWidth = System.Distance / 3.141592f;
 
     //exit early if the source string is nullptr for some reason
-    if (SourceString == nullptr)
+    if (System.GetOutputString() == nullptr)
     {
         return;
     }
-    const size_t StrLength = strlen(SourceString);
 
-    //specify max number of tris (10mil) and create list to store them all
-    constexpr unsigned int MaxTriangles = 10000000;
+    for (std::vector<SurfaceInstance>& Instances : SurfaceInstances)
+    {
+        Instances.clear();
+    }
+    SurfaceInstanceOrder.clear();
+    TwoSidedTriangles.clear();
+    Segments.clear();
+    Checkpoints.clear();
+    CheckpointBranchStates.clear();
+    PolygonDepth = 0;
+    bIsDefiningPolygon = false;
+
+    //create a list to store all triangles, up to MaxTriangles
     //auto* Triangles = new ColoredTriangleList(MaxTriangles);
     if(*List == nullptr)
     {
@@ -57,268 +158,430 @@ void Turtle::DrawSystem(LSystem& System, ColoredTriangleList** List)
     else {
         (*List)->Clear();
     }
-    auto* Triangles = *List;
 
-    LogVerbose("Turtle Processing string of length %d\n", StrLength);
+    Interpret(System, *List, 0, 0);
+}
+
+size_t Turtle::ResumeSystem(LSystem& System, ColoredTriangleList** List, const size_t FirstChangedSymbol)
+{
+    //the last checkpoint at or before the change, anything it depends on comes before it
+    const auto After = std::upper_bound(Checkpoints.begin(), Checkpoints.end(), FirstChangedSymbol,
+                                        [](const size_t Position, const Checkpoint& Saved) { return Position < Saved.Position; });
+    if (*List == nullptr || System.GetOutputString() == nullptr || After == Checkpoints.begin())
+    {
+        DrawSystem(System, List);
+        return 0;
+    }
+
+    PROFILE_SCOPE("DrawSystem");
+
+    //the checkpoint resumed from is recorded again once drawing passes it
+    const Checkpoint Resume = *(After - 1);
+    Checkpoints.erase(After - 1, Checkpoints.end());
+
+    CurrentFrame = Resume.Frame;
+    CurrentWidth = Resume.Width;
+    CurrentBranchStart = Resume.BranchStart;
+    ColorIndex = Resume.ColorIndex;
+    HueStep = Resume.HueStep;
+    UpdateColor();
+    bIsDefiningPolygon = Resume.bIsDefiningPolygon;
+    PolygonDepth = 0;
+    BranchStack.Clear();
+    for (size_t i = Resume.FirstBranchState; i < Resume.FirstBranchState + Resume.BranchDepth; i++)
+    {
+        BranchStack.Push(CheckpointBranchStates[i]);
+    }
+    CheckpointBranchStates.resize(Resume.FirstBranchState);
+
+    //everything drawn after the checkpoint is drawn again
+    ColoredTriangleList* Triangles = *List;
+    Triangles->NumTriangles = Resume.NumTriangles;
+    Triangles->BoundingBoxMin = Resume.BoundingBoxMin;
+    Triangles->BoundingBoxMax = Resume.BoundingBoxMax;
+    Segments.resize(Resume.NumSegments);
+    TwoSidedTriangles.resize(Resume.NumTwoSidedTriangles);
+    while (SurfaceInstanceOrder.size() > Resume.NumSurfaceInstances)
+    {
+        SurfaceInstances[SurfaceInstanceOrder.back()].pop_back();
+        SurfaceInstanceOrder.pop_back();
+    }
+
+    Interpret(System, Triangles, Resume.Position, Resume.ParameterOffset);
+    return Resume.Position;
+}
+
+void Turtle::RecordCheckpoint(const size_t Position, const size_t ParameterOffset, const ColoredTriangleList* Triangles)
+{
+    Checkpoint Saved;
+    Saved.Position = Position;
+    Saved.ParameterOffset = ParameterOffset;
+    Saved.Frame = CurrentFrame;
+    Saved.Width = CurrentWidth;
+    Saved.BranchStart = CurrentBranchStart;
+    Saved.ColorIndex = ColorIndex;
+    Saved.HueStep = HueStep;
+    Saved.bIsDefiningPolygon = bIsDefiningPolygon;
+    Saved.BranchDepth = static_cast<uint32_t>(BranchStack.Num());
+    Saved.FirstBranchState = CheckpointBranchStates.size();
+    Saved.NumTriangles = Triangles->NumTriangles;
+    Saved.BoundingBoxMin = Triangles->BoundingBoxMin;
+    Saved.BoundingBoxMax = Triangles->BoundingBoxMax;
+    Saved.NumSegments = Segments.size();
+    Saved.NumTwoSidedTriangles = TwoSidedTriangles.size();
+    Saved.NumSurfaceInstances = SurfaceInstanceOrder.size();
+    BranchStack.ForEach([this](const StateData& State) { CheckpointBranchStates.push_back(State); });
+    Checkpoints.push_back(Saved);
+}
+
+void Turtle::Interpret(LSystem& System, ColoredTriangleList* Triangles, const size_t Start, size_t ParameterOffset)
+{
+    //how much to decrement the width when extending via 'F'
+    const float WidthDecrement = System.Distance / 3.141592f / (3.141592f * 3.141592f * 3.141592f);
+
+    //set source string based on whether we're working off a generated string or the axiom
+    const char* SourceString = System.GetOutputString();
+    const size_t StrLength = strlen(SourceString);
+
+    //parameter stream of parametric systems, walked alongside the symbols
+    const unsigned char* ParameterCounts = System.GetOutputParameterCounts();
+    const float* Parameters = System.GetOutputParameters();
+
+    //the bracket index is only needed to cut off branches, so it's built the first time one is
+    bool bBracketIndexBuilt = false;
+
+    LogVerbose("Turtle Processing string of length %zu from %zu\n", StrLength, Start);
 
     //iterate over the string, processing symbols as we go
-    for(int i = 0; i < StrLength && Triangles->NumTriangles < MaxTriangles; i++)
+    size_t NextCheckpoint = Start;
+    for(size_t i = Start; i < StrLength && Triangles->NumTriangles < MaxTriangles; i++)
     {
-        switch (SourceString[i])
+        //state inside a polygon includes its vertices so far, so checkpoints wait until it's complete
+        if (CheckpointInterval > 0 && i >= NextCheckpoint && PolygonDepth == 0)
         {
-            case 'F':
-            {
-                CurrentHSVColor = RGBtoHSV(CurrentColor);
-                CurrentHSVColor.r = static_cast<float>(fmod(CurrentHSVColor.r + 8.0, 360.0));
+            RecordCheckpoint(i, ParameterOffset, Triangles);
+            NextCheckpoint = i + CheckpointInterval;
+        }
+
+        //parametric modules override the system's distance and angle with their first parameter, i.e. F(0.5), +(30)
+        int NumParameters = 0;
+        const float* SymbolParameters = nullptr;
+        if (ParameterCounts != nullptr)
+        {
+            NumParameters = ParameterCounts[i];
+            SymbolParameters = Parameters + ParameterOffset;
+            ParameterOffset += NumParameters;
+        }
 
-                glm::vec3 NextColor = HSVtoRGB(CurrentHSVColor);
+        const ETurtleOp Op = TurtleOps.Ops[static_cast<unsigned char>(SourceString[i])];
+        if (Op == ETurtleOp::None)
+        {
+            continue;
+        }
 
-                DrawConeSegment(CurrentWidth, CurrentWidth-WidthDecrement, CurrentColor, NextColor, System.Distance, Triangles);
-                CurrentWidth -= WidthDecrement;
-                CurrentWidth = CurrentWidth <= 0.005f ? 0.005f : CurrentWidth;
+        const float Distance = NumParameters > 0 ? SymbolParameters[0] : System.Distance;
+        const float Angle = NumParameters > 0 ? SymbolParameters[0] : System.Angle;
+
+        switch (Op)
+        {
+            //F draws a segment, G draws one without recording a vertex in the current polygon, pg 122
+            case ETurtleOp::DrawForward:
+            case ETurtleOp::DrawForwardNoRecord:
+            {
+                //each segment shades to a color HueStepDegrees further round the hue circle
+                HueStep = HueStep + 1 < HueStepsPerTurn ? HueStep + 1 : 0;
+                glm::vec3 NextColor = HuePalette.Colors[ColorIndex][HueStep];
+
+                //F(l, w) draws a segment of length l tapering from the current width to w
+                const float NextWidth = NumParameters > 1 ? SymbolParameters[1] : CurrentWidth - WidthDecrement;
+                DrawConeSegment(CurrentWidth, NextWidth, CurrentColor, NextColor, Distance, Triangles);
+                CurrentWidth = NextWidth;
+                CurrentWidth = CurrentWidth <= MinimumWidth ? MinimumWidth : CurrentWidth;
                 CurrentColor = NextColor;
-                MoveForward(System.Distance);
+                MoveForward(Distance, Op == ETurtleOp::DrawForward);
             }
             break;
 
-            case 'f':
-                MoveForward(System.Distance);
+            case ETurtleOp::MoveForward:
+                MoveForward(Distance);
             break;
 
             //yaw left right by system angle
-            case '+':
-                CurrentTransform.AdjustYaw(System.Angle);
+            case ETurtleOp::YawLeft:
+                CurrentFrame.AdjustYaw(Angle);
             break;
-            case '-':
-                CurrentTransform.AdjustYaw(-System.Angle);
+            case ETurtleOp::YawRight:
+                CurrentFrame.AdjustYaw(-Angle);
             break;
 
             //Pitch up/down by system angle
-            case '^':
-                CurrentTransform.AdjustPitch(System.Angle);
+            case ETurtleOp::PitchUp:
+                CurrentFrame.AdjustPitch(Angle);
             break;
-            case '&':
-                CurrentTransform.AdjustPitch(-System.Angle);
+            case ETurtleOp::PitchDown:
+                CurrentFrame.AdjustPitch(-Angle);
             break;
 
             //Roll right/left by system angle
-            case '\\':
-                CurrentTransform.AdjustRoll(System.Angle);
+            case ETurtleOp::RollLeft:
+                CurrentFrame.AdjustRoll(Angle);
             break;
-            case '/':
-                CurrentTransform.AdjustRoll(-System.Angle);
+            case ETurtleOp::RollRight:
+                CurrentFrame.AdjustRoll(-Angle);
             break;
 
             //Turn Around
-            case '|':
+            case ETurtleOp::TurnAround:
                 TurnAround();
             break;
 
-            case '$':
-            {
+            case ETurtleOp::RotateToVertical:
                 RotateToVertical();
-            }
             break;
 
             //start branch
-            case '[':
-                StartBranch();
+            case ETurtleOp::StartBranch:
+                StartBranch(static_cast<int>(i));
+            break;
+
+            //stop branch, ignoring unmatched brackets
+            case ETurtleOp::CompleteBranch:
+                if (CurrentBranchStart >= 0)
+                {
+                    CompleteBranch();
+                }
             break;
 
-            //stop branch
-            case ']':
+            //cut off the remainder of the branch, continuing from its ']', or stop drawing outside of a branch
+            case ETurtleOp::CutOffBranch:
             {
-                CompleteBranch();
+                if (!bBracketIndexBuilt)
+                {
+                    BuildBracketIndex(SourceString, StrLength, BracketMatch);
+                    if (ParameterCounts != nullptr)
+                    {
+                        ParameterOffsets.resize(StrLength);
+                        uint32_t Offset = 0;
+                        for (size_t p = 0; p < StrLength; p++)
+                        {
+                            ParameterOffsets[p] = Offset;
+                            Offset += ParameterCounts[p];
+                        }
+                    }
+                    bBracketIndexBuilt = true;
+                }
+
+                const int BranchEnd = CurrentBranchStart >= 0 ? BracketMatch[CurrentBranchStart] : -1;
+                const size_t Next = BranchEnd >= 0 ? static_cast<size_t>(BranchEnd) : StrLength;
+                if (ParameterCounts != nullptr && Next < StrLength)
+                {
+                    ParameterOffset = ParameterOffsets[Next];
+                }
+                i = Next - 1;
             }
             break;
 
             //begin polygon
-            case '{':
-            {
+            case ETurtleOp::StartPolygon:
                 StartPolygon();
-            }
             break;
 
-            case 'G':
-                //implement Move forward and draw a line. do not record a vertex, pg 122
+            //record a vertex in the current polygon (pg 122, 127)
+            case ETurtleOp::RecordVertex:
+                RecordVertex();
             break;
 
-            case '.':
-                //todo: implement record a vertex in the current polygon (pg 122, 127)
+            case ETurtleOp::CompletePolygon:
+                CompletePolygon();
             break;
 
-            case '}':
+            //~X incorporates the predefined surface X, the name isn't interpreted as a symbol of its own
+            case ETurtleOp::PredefinedSurface:
             {
-                CompletePolygon(Triangles);
+                char SurfaceName = '\0';
+                if (i + 1 < StrLength && isalnum(static_cast<unsigned char>(SourceString[i + 1])))
+                {
+                    SurfaceName = SourceString[++i];
+                    ParameterOffset += ParameterCounts != nullptr ? ParameterCounts[i] : 0;
+                }
+                IncorporatePredefinedSurface(SurfaceName, Distance);
             }
             break;
 
-            case '~':
-                //todo: implement incorporation of predefined surface
-            break;
-
-            case '!':
-                //todo: implement decrement diamater of segments
+            //!(w) sets the width of following segments, ! decrements it
+            case ETurtleOp::DecrementWidth:
+                if (NumParameters > 0)
+                {
+                    CurrentWidth = SymbolParameters[0];
+                }
+                else
+                {
+                    DecrementSegmentDiameter();
+                }
             break;
 
-            case '`':
-                //todo: implement increment current color index
+            //' and ` advance the color index, '(n) sets it
+            case ETurtleOp::IncrementColorIndex:
+                IncrementColorIndex(NumParameters > 0 ? static_cast<int>(SymbolParameters[0]) : -1);
             break;
 
-            case '%':
-                //todo: implement cut off remainder of branch
-            break;
             default:
             break;
         }
     }
-}
-
-void Turtle::DrawConeSegment(float r1, float r2, glm::vec3& color1, glm::vec3& color2, float length, ColoredTriangleList* triangles) const {
-    // Define vertices for the cone segment
-    const glm::vec3 start = CurrentTransform.GetLocation();
-    const glm::vec3 end = start + CurrentTransform.GetForwardVector() * length;
-
-    constexpr int numSides = 11; // Number of sides for the cone
-    glm::vec3 circleStart[numSides];
-    glm::vec3 circleEnd[numSides];
 
-    // Generate circular cross sections
-    for (int i = 0; i < numSides; ++i)
+    //two-sided triangles go last, so they can be drawn as one range without back face culling
+    Triangles->FirstTwoSidedTriangle = Triangles->NumTriangles;
+    for(ColoredTriangle& Triangle : TwoSidedTriangles)
     {
-        double angle = (2.0f * M_PI * i) / numSides;
-        double angle2= angle + (2.0f * M_PI * 0.5) / numSides;
-        double x = cos(angle);
-        double z = sin(angle);
-        double x2 = cos(angle2);
-        double z2 = sin(angle2);
-        auto r1x = static_cast<float>(r1 * x);
-        auto r1z = static_cast<float>(r1 * z);
-        auto r2x2 = static_cast<float>(r2 * x2);
-        auto r2z2 = static_cast<float>(r2 * z2);
-        circleStart[i] = start + CurrentTransform.GetRightVector() * r1x
-                               +CurrentTransform.GetUpVector() * r1z;
-        circleEnd[i] = end + CurrentTransform.GetRightVector() * r2x2
-                           + CurrentTransform.GetUpVector() * r2z2;
+        if(Triangles->NumTriangles >= MaxTriangles)
+        {
+            break;
+        }
+        Triangles->AddTriangle(Triangle);
     }
+}
 
-    // Generate triangles for the cone
-    for (int CurrentIndex = 0; CurrentIndex < numSides; ++CurrentIndex)
+bool Turtle::DrawConeSegment(float r1, float r2, glm::vec3& color1, glm::vec3& color2, float length, ColoredTriangleList* triangles)
+{
+    constexpr int NumTriangles = ConeSegment::FullDetailSides * 2;
+    if (triangles->NumTriangles + NumTriangles > triangles->MaxTriangles)
     {
-        int NextIndex = (CurrentIndex + 1) % numSides;
-
-        ColoredTriangle t1;
-        //set vertex locations
-        t1.VertexLocations[0] = circleStart[CurrentIndex];
-        t1.VertexLocations[1] = circleStart[NextIndex];
-        t1.VertexLocations[2] = circleEnd[CurrentIndex];
-        //assign colors
-        t1.VertexColors[0] = color1;
-        t1.VertexColors[1] = color1;
-        t1.VertexColors[2] = color2;
-        //calculate normals
-        glm::vec3 v1 = t1.VertexLocations[1] - t1.VertexLocations[0];
-        glm::vec3 v2 = t1.VertexLocations[2] - t1.VertexLocations[0];
-
-        glm::vec3 normal = glm::cross(v1, v2);
-        for(auto& Normal : t1.VertexNormals) {
-            Normal = normal;
-        }
+        return false;
+    }
 
-        ColoredTriangle t2;
-        t2.VertexLocations[0] = circleEnd[NextIndex];
-        t2.VertexLocations[1] = circleEnd[CurrentIndex];
-        t2.VertexLocations[2] = circleStart[NextIndex];
-        t2.VertexColors[0] = color2;
-        t2.VertexColors[1] = color2;
-        t2.VertexColors[2] = color1;
-        v1 = t2.VertexLocations[1] - t2.VertexLocations[0];
-        v2 = t2.VertexLocations[2] - t2.VertexLocations[0];
-        normal = glm::cross(v1, v2);
-        for(auto& Normal : t2.VertexNormals) {
-            Normal = normal;
-        }
+    const glm::vec3 start = CurrentFrame.Location;
+    const ConeSegment Segment = {start, r1, start + CurrentFrame.GetForwardVector() * length, r2,
+        CurrentFrame.GetRightVector(), CurrentFrame.GetUpVector(), color1, color2};
 
-        triangles->AddTriangle(t1);
-        triangles->AddTriangle(t2);
+    ColoredTriangle SegmentTriangles[NumTriangles];
+    Segment.Triangulate(ConeSegment::FullDetailSides, SegmentTriangles);
+    for (ColoredTriangle& Triangle : SegmentTriangles)
+    {
+        triangles->AddTriangle(Triangle);
     }
+    Segments.push_back(Segment);
+    return true;
 }
 
-void Turtle::StartBranch()
+void Turtle::StartBranch(int BranchStart)
 {
-    BranchStack.Push({bIsDefiningPolygon, CurrentWidth, CurrentTransform, CurrentColor});
+    const StateData Data = {CurrentFrame, CurrentWidth, CurrentBranchStart, static_cast<uint8_t>(ColorIndex), HueStep,
+        bIsDefiningPolygon, static_cast<uint16_t>(PolygonDepth)};
+    if(!BranchStack.Push(Data))
+    {
+        LogError("out of memory saving branch state, branch ignored\n");
+        return;
+    }
+    CurrentBranchStart = BranchStart;
 }
 
 void Turtle::CompleteBranch()
 {
-    StateData Data = BranchStack.Pop();
+    StateData Data;
+    if(!BranchStack.Pop(Data))
+    {
+        LogWarning("] without a matching [, ignored\n");
+        return;
+    }
+    CurrentFrame = Data.Frame;
+    CurrentWidth = Data.Width;
+    CurrentBranchStart = Data.BranchStart;
+    ColorIndex = Data.ColorIndex;
+    HueStep = Data.HueStep;
+    UpdateColor();
     bIsDefiningPolygon = Data.bIsDefiningPolygon;
-    CurrentWidth = Data.CurrentWidth;
-    CurrentTransform = Data.CurrentTransform;
-    CurrentColor = Data.CurrentColor;
+
+    //polygons opened within the branch and left open, by a cut skipping their } or an unbalanced string, end with it
+    //and are dropped, so later vertices don't go into them
+    while (PolygonDepth > Data.PolygonDepth)
+    {
+        PolygonStack[--PolygonDepth].clear();
+    }
 }
 
 void Turtle::StartPolygon()
 {
-    //set ourselves to be
+    //polygons nest, each level keeps its own vertex list, and the lists are kept around so their storage is reused
+    if(PolygonDepth == PolygonStack.size())
+    {
+        PolygonStack.emplace_back();
+        PolygonStack.back().reserve(16);
+    }
+    PolygonStack[PolygonDepth++].clear();
+
     bIsDefiningPolygon = true;
-    PolygonStartTransform = CurrentTransform;
-    polygonVertices.push_back(CurrentTransform.GetLocation());
+    RecordVertex();
 }
 
-void Turtle::CompletePolygon(ColoredTriangleList* triangles)
+void Turtle::RecordVertex()
 {
-    bIsDefiningPolygon = false;
-
-    //remove last vertex if it matches the first, as we're going to iterate through them
-    if(polygonVertices.size() > 1 && polygonVertices[0] == polygonVertices[polygonVertices.size()-1])
+    if(bIsDefiningPolygon && PolygonDepth > 0)
     {
-        polygonVertices.pop_back();
+        PolygonStack[PolygonDepth - 1].push_back(CurrentFrame.Location);
     }
+}
 
-    //use static polygon color
-    glm::vec3 color = {0.1f, 0.3f, 0.2f};
-
-    //placeholder top and bottom triangles we're working with
-    //top triangle always has the same start vertex, as we're filling a polygon
-    //color also stays the same throughout
-    ColoredTriangle TopTriangle, BottomTriangle;
-    TopTriangle.VertexLocations[0] = polygonVertices[0];
-    TopTriangle.VertexColors[0] = BottomTriangle.VertexColors[0] =  color;
-    TopTriangle.VertexColors[1] = BottomTriangle.VertexColors[1] =  color;
-    TopTriangle.VertexColors[2] = BottomTriangle.VertexColors[2] =  color;
-
-    //for each polygon other than the first, create a triangle with the next two vertices in the sequence
-    for(int i = 1; i < polygonVertices.size()-1; i++)
+void Turtle::CompletePolygon()
+{
+    if(PolygonDepth == 0)
     {
-        //set vertices 1 and 2 of the triangle to polgon vertices i and i+1, and keep track of them
-        glm::vec3 v1 = TopTriangle.VertexLocations[1] = polygonVertices[i];
-        glm::vec3 v2 = TopTriangle.VertexLocations[2] = polygonVertices[i + 1];
-
-        //subtract constant VertexLocations[0] from both and calculate normal based on it
-        v1 -= TopTriangle.VertexLocations[0];
-        v2 -= TopTriangle.VertexLocations[0];
-        glm::vec3 TopTriangleNormal = glm::cross(v1, v2);
+        return;
+    }
+    std::vector<glm::vec3>& Vertices = PolygonStack[--PolygonDepth];
+    bIsDefiningPolygon = PolygonDepth > 0;
 
-        //set normals for both triangles, set location of bottom triangle to slightly below top triangle, and flip winding
-        for(int j = 0; j < 3; j++)
+    //triangulate in the polygon's plane, polygons are single sided and lit from both sides by the shader
+    if(TriangulatePolygon(Vertices.data(), Vertices.size(), PolygonIndices, PolygonNormal, PolygonScratch))
+    {
+        ColoredTriangle Triangle;
+        for(size_t i = 0; i < PolygonIndices.size(); i += 3)
         {
-            TopTriangle.VertexNormals[j] = TopTriangleNormal;
-            BottomTriangle.VertexNormals[j] = -TopTriangleNormal;
-            BottomTriangle.VertexLocations[j] = TopTriangle.VertexLocations[2-j] - (PolygonStartTransform.GetUpVector() * .001f);
+            for(int j = 0; j < 3; j++)
+            {
+                Triangle.VertexLocations[j] = Vertices[PolygonIndices[i + j]];
+                Triangle.VertexColors[j] = CurrentColor;
+                Triangle.VertexNormals[j] = PolygonNormal;
+            }
+            TwoSidedTriangles.push_back(Triangle);
         }
-
-        //add top and bottom triangles to our list
-        triangles->AddTriangle(TopTriangle);
-        triangles->AddTriangle(BottomTriangle);
     }
 
-    polygonVertices.clear();
+    Vertices.clear();
+}
+
+void Turtle::IncorporatePredefinedSurface(char SurfaceName, float Scale)
+{
+    //only the placement is recorded, the surface's mesh is shared by every instance of it
+    const unsigned char Name = static_cast<unsigned char>(SurfaceName) & 127;
+    SurfaceInstances[Name].push_back({CurrentFrame.Location, Scale,
+                                      CurrentFrame.GetRightVector(), CurrentFrame.GetUpVector(),
+                                      CurrentFrame.GetForwardVector(), CurrentColor});
+    SurfaceInstanceOrder.push_back(Name);
+}
+
+void Turtle::DecrementSegmentDiameter()
+{
+    CurrentWidth *= WidthDecrementRatio;
+    CurrentWidth = CurrentWidth <= MinimumWidth ? MinimumWidth : CurrentWidth;
+}
+
+void Turtle::IncrementColorIndex(int NewIndex)
+{
+    ColorIndex = NewIndex >= 0 ? NewIndex : ColorIndex + 1;
+    ColorIndex = ColorIndex < ColorIndexPaletteSize ? ColorIndex : ColorIndexPaletteSize - 1;
+    HueStep = 0;
+    UpdateColor();
+}
+
+void Turtle::UpdateColor()
+{
+    CurrentColor = HuePalette.Colors[ColorIndex][HueStep];
 }
 
 void Turtle::TurnAround()
 {
-    CurrentTransform.AdjustYaw(180);
+    CurrentFrame.AdjustYaw(180);
 }
 
 void Turtle::RotateToVertical()
@@ -338,11 +601,11 @@ void Turtle::RotateToVertical()
      * L = V cross H / length(V cross H)
      */
 
-    glm::vec3 NewLeftDir = glm::cross(Transform::WorldUp, CurrentTransform.GetForwardVector());
+    glm::vec3 NewLeftDir = glm::cross(Transform::WorldUp, CurrentFrame.GetForwardVector());
     NewLeftDir = NewLeftDir / glm::length(NewLeftDir);
 
-    const glm::vec3 NewUpDir = glm::normalize(glm::cross(CurrentTransform.GetForwardVector(), NewLeftDir));
-    const glm::mat3 RotationMatrix(CurrentTransform.GetForwardVector(), NewUpDir, NewLeftDir);
-    CurrentTransform.SetRotation(RotationMatrix);
+    const glm::vec3 NewUpDir = glm::normalize(glm::cross(CurrentFrame.GetForwardVector(), NewLeftDir));
+    const glm::mat3 RotationMatrix(CurrentFrame.GetForwardVector(), NewUpDir, NewLeftDir);
+    CurrentFrame.Rotation = glm::quat(RotationMatrix);
 }
 
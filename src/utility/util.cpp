@@ -90,8 +90,13 @@ glm::vec3 RGBtoHSV(const glm::vec3& rgb) {
 }
 
 // Function to generate a sphere
-std::vector<glm::vec3> GenerateSphere(glm::vec3 Center, float Radius, unsigned int LongitudeSegments, unsigned int LatitudeSegments) {
-    std::vector<glm::vec3> vertices;
+glm::vec3* GenerateSphere(glm::vec3 Center, float Radius, unsigned int LongitudeSegments, unsigned int LatitudeSegments, Arena& Memory, int& NumVertices) {
+    NumVertices = 0;
+    glm::vec3* vertices = Memory.AllocateArray<glm::vec3>((LatitudeSegments + 1) * (LongitudeSegments + 1));
+    glm::vec3* triangles = Memory.AllocateArray<glm::vec3>(LatitudeSegments * LongitudeSegments * 6);
+    if (vertices == nullptr || triangles == nullptr) {
+        return nullptr;
+    }
 
     for (unsigned int lat = 0; lat <= LatitudeSegments; ++lat) {
         float theta = glm::radians(180.0f * static_cast<float>(lat) / LatitudeSegments); // Latitude angle
@@ -104,13 +109,10 @@ std::vector<glm::vec3> GenerateSphere(glm::vec3 Center, float Radius, unsigned i
             float cosPhi = std::cos(phi);
 
             // Calculate vertex position
-            glm::vec3 vertex = Center + Radius * glm::vec3(cosPhi * sinTheta, cosTheta, sinPhi * sinTheta);
-            vertices.push_back(vertex);
+            vertices[lat * (LongitudeSegments + 1) + lon] = Center + Radius * glm::vec3(cosPhi * sinTheta, cosTheta, sinPhi * sinTheta);
         }
     }
 
-    std::vector<glm::vec3> triangles;
-
     // Create triangles from the sphere vertices
     for (unsigned int lat = 0; lat < LatitudeSegments; ++lat) {
         for (unsigned int lon = 0; lon < LongitudeSegments; ++lon) {
@@ -118,14 +120,14 @@ std::vector<glm::vec3> GenerateSphere(glm::vec3 Center, float Radius, unsigned i
             unsigned int second = first + LongitudeSegments + 1;
 
             // First triangle of the quad
-            triangles.push_back(vertices[first]);
-            triangles.push_back(vertices[second]);
-            triangles.push_back(vertices[first + 1]);
+            triangles[NumVertices++] = vertices[first];
+            triangles[NumVertices++] = vertices[second];
+            triangles[NumVertices++] = vertices[first + 1];
 
             // Second triangle of the quad
-            triangles.push_back(vertices[second]);
-            triangles.push_back(vertices[second + 1]);
-            triangles.push_back(vertices[first + 1]);
+            triangles[NumVertices++] = vertices[second];
+            triangles[NumVertices++] = vertices[second + 1];
+            triangles[NumVertices++] = vertices[first + 1];
         }
     }
 